@@ -0,0 +1,430 @@
+#ifndef ARCHIVE_SOURCE_H
+#define ARCHIVE_SOURCE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <lzma.h>
+
+#include "frame_source.h"
+
+// --------------------------------------------------------------------
+// Streams one member file out of a .tar.xz archive.
+//
+// A background thread decompresses the archive with liblzma, walks the
+// tar headers and pushes the bytes of the first regular file whose
+// name ends in 'memberName' into a bounded queue of chunks. read()
+// hands chunks to the consumer, so at most MAX_QUEUED_CHUNKS *
+// CHUNK_SIZE bytes are buffered and the first data is available as
+// soon as the first block is decompressed.
+//
+// Only what the rover archives need is supported: ustar/GNU headers,
+// with GNU long names and pax headers skipped.
+// --------------------------------------------------------------------
+class XzTarStream {
+public:
+    static const size_t CHUNK_SIZE = 256 * 1024;
+    static const size_t MAX_QUEUED_CHUNKS = 32;   // 8 MB read-ahead
+
+    XzTarStream(const std::string& archivePath, const std::string& memberName)
+        : m_archivePath(archivePath), m_memberName(memberName)
+    {
+        m_thread = std::thread([this] { run(); });
+    }
+
+    ~XzTarStream()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_cv.notify_all();
+        m_thread.join();
+    }
+
+    // Blocks until the next chunk of file data is available. Returns
+    // false at the end of the member (or on error, see failed()). The
+    // previous contents of 'chunk' are recycled.
+    bool read(std::vector<char>& chunk)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (chunk.capacity() > 0) {
+            m_free.push_back(std::move(chunk));
+        }
+        m_cv.notify_all();
+        m_cv.wait(lock, [this] { return !m_ready.empty() || m_finished; });
+        if (m_ready.empty()) {
+            chunk.clear();
+            return false;
+        }
+        chunk = std::move(m_ready.front());
+        m_ready.pop_front();
+        m_cv.notify_all();
+        return true;
+    }
+
+    bool failed() const { return m_failed; }
+
+private:
+    enum class TarState { Header, Skip, Member, Done };
+
+    void run()
+    {
+        bool ok = decompress();
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!ok || !m_foundMember) {
+            if (!m_stop) {
+                if (ok) {
+                    std::cerr << "Error: no " << m_memberName << " in " << m_archivePath << "\n";
+                }
+                m_failed = true;
+            }
+        }
+        if (!m_output.empty()) {
+            m_ready.push_back(std::move(m_output));
+        }
+        m_finished = true;
+        m_cv.notify_all();
+    }
+
+    bool decompress()
+    {
+        FILE* file = std::fopen(m_archivePath.c_str(), "rb");
+        if (!file) {
+            std::cerr << "Error: cannot open archive: " << m_archivePath << "\n";
+            return false;
+        }
+
+        lzma_stream strm = LZMA_STREAM_INIT;
+        if (lzma_stream_decoder(&strm, UINT64_MAX, LZMA_CONCATENATED) != LZMA_OK) {
+            std::cerr << "Error: cannot initialise xz decoder\n";
+            std::fclose(file);
+            return false;
+        }
+
+        std::vector<uint8_t> inBuf(64 * 1024);
+        std::vector<uint8_t> outBuf(CHUNK_SIZE);
+        lzma_action action = LZMA_RUN;
+        bool ok = true;
+
+        while (m_state != TarState::Done) {
+            if (strm.avail_in == 0 && action == LZMA_RUN) {
+                strm.next_in = inBuf.data();
+                strm.avail_in = std::fread(inBuf.data(), 1, inBuf.size(), file);
+                if (std::ferror(file)) {
+                    std::cerr << "Error: cannot read archive: " << m_archivePath << "\n";
+                    ok = false;
+                    break;
+                }
+                if (std::feof(file)) {
+                    action = LZMA_FINISH;
+                }
+            }
+
+            strm.next_out = outBuf.data();
+            strm.avail_out = outBuf.size();
+            lzma_ret ret = lzma_code(&strm, action);
+
+            if (!consume(outBuf.data(), outBuf.size() - strm.avail_out)) {
+                break;  // stopped by the consumer
+            }
+            if (ret == LZMA_STREAM_END) {
+                break;
+            }
+            if (ret != LZMA_OK) {
+                std::cerr << "Error: corrupt archive " << m_archivePath << " (xz error " << ret << ")\n";
+                ok = false;
+                break;
+            }
+        }
+
+        lzma_end(&strm);
+        std::fclose(file);
+        return ok;
+    }
+
+    // Feeds decompressed bytes through the tar state machine. Returns
+    // false if the stream was stopped.
+    bool consume(const uint8_t* data, size_t size)
+    {
+        while (size > 0 && m_state != TarState::Done) {
+            if (m_state == TarState::Header) {
+                size_t n = std::min(size, sizeof(m_header) - m_headerFill);
+                std::memcpy(m_header + m_headerFill, data, n);
+                m_headerFill += n;
+                data += n;
+                size -= n;
+                if (m_headerFill == sizeof(m_header)) {
+                    m_headerFill = 0;
+                    parseHeader();
+                }
+                continue;
+            }
+
+            size_t n = static_cast<size_t>(std::min<uint64_t>(size, m_remaining));
+            if (m_state == TarState::Member && m_memberLeft > 0) {
+                size_t payload = static_cast<size_t>(std::min<uint64_t>(n, m_memberLeft));
+                if (!emit(reinterpret_cast<const char*>(data), payload)) {
+                    return false;
+                }
+                m_memberLeft -= payload;
+                if (m_memberLeft == 0) {
+                    m_state = TarState::Done;  // nothing after the member is needed
+                    return true;
+                }
+            }
+            data += n;
+            size -= n;
+            m_remaining -= n;
+            if (m_remaining == 0) {
+                m_state = TarState::Header;
+            }
+        }
+        return true;
+    }
+
+    void parseHeader()
+    {
+        // Two zero blocks end the archive; one is enough to stop looking
+        bool zero = true;
+        for (char c : m_header) {
+            zero = zero && c == 0;
+        }
+        if (zero) {
+            m_state = TarState::Done;
+            return;
+        }
+
+        uint64_t size = parseSize(m_header + 124, 12);
+        uint64_t padded = (size + 511) & ~uint64_t(511);
+        char type = m_header[156];
+
+        std::string name(m_header, strnlen(m_header, 100));
+        if (std::memcmp(m_header + 257, "ustar\0", 6) == 0 && m_header[345] != 0) {
+            name = std::string(m_header + 345, strnlen(m_header + 345, 155)) + "/" + name;
+        }
+
+        bool regular = (type == '0' || type == '\0');
+        bool matches = name.size() >= m_memberName.size() &&
+                       name.compare(name.size() - m_memberName.size(), m_memberName.size(), m_memberName) == 0;
+
+        m_remaining = padded;
+        m_state = TarState::Skip;
+        if (regular && matches) {
+            m_foundMember = true;
+            m_memberLeft = size;
+            m_state = TarState::Member;
+        }
+        if (m_remaining == 0) {
+            m_state = (m_state == TarState::Member) ? TarState::Done : TarState::Header;
+        }
+    }
+
+    // Octal, or GNU base-256 when the top bit is set
+    static uint64_t parseSize(const char* field, size_t len)
+    {
+        uint64_t value = 0;
+        if (static_cast<unsigned char>(field[0]) & 0x80) {
+            for (size_t i = 1; i < len; ++i) {
+                value = (value << 8) | static_cast<unsigned char>(field[i]);
+            }
+            return value;
+        }
+        for (size_t i = 0; i < len && field[i]; ++i) {
+            if (field[i] >= '0' && field[i] <= '7') {
+                value = value * 8 + static_cast<uint64_t>(field[i] - '0');
+            }
+        }
+        return value;
+    }
+
+    // Appends member bytes to the current chunk, queueing full chunks.
+    // Blocks while the queue is full; returns false if stopped.
+    bool emit(const char* data, size_t size)
+    {
+        while (size > 0) {
+            if (m_output.capacity() < CHUNK_SIZE) {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (!m_free.empty()) {
+                    m_output = std::move(m_free.back());
+                    m_free.pop_back();
+                }
+                m_output.clear();
+                m_output.reserve(CHUNK_SIZE);
+            }
+            size_t n = std::min(size, CHUNK_SIZE - m_output.size());
+            m_output.insert(m_output.end(), data, data + n);
+            data += n;
+            size -= n;
+
+            if (m_output.size() == CHUNK_SIZE) {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_cv.wait(lock, [this] { return m_ready.size() < MAX_QUEUED_CHUNKS || m_stop; });
+                if (m_stop) {
+                    return false;
+                }
+                m_ready.push_back(std::move(m_output));
+                m_output = std::vector<char>();
+                m_cv.notify_all();
+            }
+        }
+        return true;
+    }
+
+    std::string m_archivePath;
+    std::string m_memberName;
+
+    // Decoder thread state
+    TarState m_state = TarState::Header;
+    char m_header[512];
+    size_t m_headerFill = 0;
+    uint64_t m_remaining = 0;     // bytes left in the current entry, with padding
+    uint64_t m_memberLeft = 0;    // member payload bytes still to emit
+    bool m_foundMember = false;
+    std::vector<char> m_output;   // chunk being filled
+
+    // Shared with the consumer, guarded by m_mutex
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::deque<std::vector<char>> m_ready;
+    std::vector<std::vector<char>> m_free;
+    bool m_finished = false;
+    bool m_stop = false;
+    std::atomic<bool> m_failed{false};
+
+    std::thread m_thread;
+};
+
+// --------------------------------------------------------------------
+// Replays a rover log straight out of its .tar.xz archive, without
+// extracting it. Frames are parsed from the decompressed stream as it
+// arrives.
+//
+// The stream can only go forward: seek() skips lines ahead, or restarts
+// decompression from the top for a backward seek. The frame count is
+// unknown until the end of the data has been seen once.
+// --------------------------------------------------------------------
+class ArchiveFrameSource : public FrameSource {
+public:
+    bool open(const std::string& archivePath, const std::string& memberName)
+    {
+        m_archivePath = archivePath;
+        m_memberName = memberName;
+        restart();
+        // Wait for the first data so a bad archive fails at startup
+        if (!fillChunk()) {
+            if (!m_stream->failed()) {
+                std::cerr << "Error: " << memberName << " in " << archivePath << " is empty\n";
+            }
+            return false;
+        }
+        return true;
+    }
+
+    uint32_t frameCount() const override { return m_frameCount; }
+    uint32_t position() const override { return m_nextFrame; }
+
+    bool seek(uint32_t frame) override
+    {
+        if (frame < m_nextFrame) {
+            restart();
+        }
+        while (m_nextFrame < frame) {
+            if (!readLine(nullptr)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool next(Frame& frame) override
+    {
+        for (;;) {
+            if (!readLine(&m_line)) {
+                return false;
+            }
+            if (!parseLine(m_line.data(), m_line.data() + m_line.size(),
+                           m_pose[0], m_pose[1], m_pose[2],
+                           m_pose[3], m_pose[4], m_pose[5], m_cloud)) {
+                continue;  // malformed line, still counted as a frame
+            }
+            frame.posX = m_pose[0]; frame.posY = m_pose[1]; frame.posZ = m_pose[2];
+            frame.rotX = m_pose[3]; frame.rotY = m_pose[4]; frame.rotZ = m_pose[5];
+            frame.storage.swap(m_cloud);
+            frame.points = frame.storage.data();
+            frame.numPoints = frame.storage.size();
+            return true;
+        }
+    }
+
+private:
+    void restart()
+    {
+        m_stream.reset();  // stop the old decoder thread first
+        m_stream = std::make_unique<XzTarStream>(m_archivePath, m_memberName);
+        m_chunk.clear();
+        m_pos = 0;
+        m_nextFrame = 0;
+    }
+
+    bool fillChunk()
+    {
+        m_pos = 0;
+        return m_stream->read(m_chunk);
+    }
+
+    // Reads the next non-empty line into 'line' (or just skips it when
+    // line is null). Returns false at the end of the data.
+    bool readLine(std::string* line)
+    {
+        if (line) {
+            line->clear();
+        }
+        bool hasData = false;
+        for (;;) {
+            if (m_pos == m_chunk.size() && !fillChunk()) {
+                if (hasData) {
+                    break;  // last line without a newline
+                }
+                m_frameCount = m_nextFrame;
+                return false;
+            }
+            const char* begin = m_chunk.data() + m_pos;
+            const char* end = m_chunk.data() + m_chunk.size();
+            const char* nl = static_cast<const char*>(std::memchr(begin, '\n', end - begin));
+            const char* stop = nl ? nl : end;
+            if (line) {
+                line->append(begin, stop);
+            }
+            hasData = hasData || stop > begin;
+            m_pos = static_cast<size_t>(stop - m_chunk.data()) + (nl ? 1 : 0);
+            if (nl && hasData) {
+                break;
+            }
+        }
+        ++m_nextFrame;
+        return true;
+    }
+
+    std::string m_archivePath;
+    std::string m_memberName;
+    std::unique_ptr<XzTarStream> m_stream;
+    std::vector<char> m_chunk;
+    size_t m_pos = 0;
+    uint32_t m_nextFrame = 0;
+    std::atomic<uint32_t> m_frameCount{UINT32_MAX};  // read by the command handler
+    std::string m_line;
+    float m_pose[6] = {};
+    std::vector<LidarPoint> m_cloud;
+};
+
+#endif // ARCHIVE_SOURCE_H
@@ -0,0 +1,241 @@
+#ifndef DAT_PARSER_H
+#define DAT_PARSER_H
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "rover_packets.h"
+
+// --------------------------------------------------------------------
+// Streaming parser for the rover .dat line format.
+//
+// Format: posX,posY,posZ,rotX,rotY,rotZ; x1,y1,z1; x2,y2,z2; ...
+//
+// Works directly on the line's characters: no substrings, no token
+// vectors, and points are appended to a caller-owned vector that keeps
+// its capacity between lines, so steady-state parsing never allocates.
+// --------------------------------------------------------------------
+
+namespace datparse {
+
+inline bool isSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+inline const char* skipSpaces(const char* p, const char* end)
+{
+    while (p < end && isSpace(*p)) {
+        ++p;
+    }
+    return p;
+}
+
+// --------------------------------------------------------------------
+// SWAR digit helpers: examine 8 characters per 64-bit load.
+// Byte 0 of the loaded word is the first character (little-endian).
+// --------------------------------------------------------------------
+inline uint64_t load8(const char* p)
+{
+    uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+// Number of leading ASCII digits in the 8-byte word (0..8)
+inline int leadingDigits(uint64_t v)
+{
+    uint64_t x = v ^ 0x3030303030303030ULL;  // digits become 0x00..0x09
+    // High bit of a byte is set iff that byte is not a digit; masking
+    // bit 7 first keeps the addition from carrying into the next byte.
+    uint64_t nonDigit = (((x & 0x7F7F7F7F7F7F7F7FULL) + 0x7676767676767676ULL) | x)
+                        & 0x8080808080808080ULL;
+    if (nonDigit == 0) {
+        return 8;
+    }
+    return __builtin_ctzll(nonDigit) / 8;
+}
+
+// Value of the first 'count' (1..8) digits of the word
+inline uint32_t digitsValue(uint64_t v, int count)
+{
+    uint64_t val = (v ^ 0x3030303030303030ULL) << (8 * (8 - count));  // pad with leading zeros
+    val = (val * 10) + (val >> 8);
+    val = (((val & 0x000000FF000000FFULL) * (100 + (1000000ULL << 32))) +
+           (((val >> 16) & 0x000000FF000000FFULL) * (1 + (10000ULL << 32)))) >> 32;
+    return static_cast<uint32_t>(val);
+}
+
+// --------------------------------------------------------------------
+// Fast path for plain fixed-point decimals ("-123.456"). Handles
+// values whose digits fit in 24 bits with at most 10 decimals, where a
+// single float division is exact-rounded (same result as strtof).
+// Returns nullptr when the text needs the general parser.
+// --------------------------------------------------------------------
+inline const char* parseFixedFloat(const char* p, const char* end, float& out)
+{
+    static const float kPow10[] = { 1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f,
+                                    1e6f, 1e7f, 1e8f, 1e9f, 1e10f };
+    static const uint32_t kIntPow10[] = { 1, 10, 100, 1000, 10000, 100000,
+                                          1000000, 10000000, 100000000 };
+
+    bool negative = false;
+    if (p < end && *p == '-') {
+        negative = true;
+        ++p;
+    }
+    // Need a full word for each digit run (intPart, '.', fraction)
+    if (end - p < 8) {
+        return nullptr;
+    }
+
+    uint64_t word = load8(p);
+    int intDigits = leadingDigits(word);
+    if (intDigits == 0 || intDigits == 8) {
+        return nullptr;
+    }
+    uint64_t mantissa = digitsValue(word, intDigits);
+    p += intDigits;
+
+    int fracDigits = 0;
+    if (*p == '.') {
+        ++p;
+        if (end - p < 8) {
+            return nullptr;
+        }
+        word = load8(p);
+        fracDigits = leadingDigits(word);
+        if (fracDigits == 8) {
+            return nullptr;
+        }
+        if (fracDigits > 0) {
+            mantissa = mantissa * kIntPow10[fracDigits] + digitsValue(word, fracDigits);
+            p += fracDigits;
+        }
+    }
+
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        return nullptr;
+    }
+    if (mantissa > (1u << 24) || fracDigits > 10) {
+        return nullptr;
+    }
+
+    float value = static_cast<float>(mantissa) / kPow10[fracDigits];
+    out = negative ? -value : value;
+    return p;
+}
+
+// --------------------------------------------------------------------
+// Parses one float at p (leading spaces allowed). Returns the position
+// after the number, or nullptr if there is no number.
+// --------------------------------------------------------------------
+template <bool UseFastPath>
+inline const char* parseFloat(const char* p, const char* end, float& out)
+{
+    p = skipSpaces(p, end);
+    if (UseFastPath) {
+        if (const char* next = parseFixedFloat(p, end, out)) {
+            return next;
+        }
+    }
+    if (p < end && *p == '+') {
+        ++p;  // from_chars rejects an explicit '+'
+    }
+    std::from_chars_result res = std::from_chars(p, end, out);
+    if (res.ec != std::errc()) {
+        return nullptr;
+    }
+    return res.ptr;
+}
+
+// Parses "a<sep>b<sep>c..." into count floats. Returns position after the last.
+template <bool UseFastPath>
+inline const char* parseFloatList(const char* p, const char* end, float* out, int count)
+{
+    for (int i = 0; i < count; ++i) {
+        if (i > 0) {
+            p = skipSpaces(p, end);
+            if (p >= end || *p != ',') {
+                return nullptr;
+            }
+            ++p;
+        }
+        p = parseFloat<UseFastPath>(p, end, out[i]);
+        if (!p) {
+            return nullptr;
+        }
+    }
+    return p;
+}
+
+} // namespace datparse
+
+// --------------------------------------------------------------------
+// parseLine: Given a single line from the data file, parse the pose
+// and the list of LiDAR points. 'cloud' is cleared and refilled.
+//
+// Point tokens that are empty or malformed are skipped.
+// UseFastPath=false forces std::from_chars for every number.
+// --------------------------------------------------------------------
+template <bool UseFastPath = true>
+inline bool parseLine(const char* begin, const char* end,
+                      float& posX, float& posY, float& posZ,
+                      float& rotX, float& rotY, float& rotZ,
+                      std::vector<LidarPoint>& cloud)
+{
+    const char* semicolon = static_cast<const char*>(std::memchr(begin, ';', end - begin));
+    if (!semicolon) {
+        std::cerr << "Invalid line (no semicolon): "
+                  << std::string(begin, std::min<size_t>(end - begin, 80)) << std::endl;
+        return false;
+    }
+
+    // 1) Pose part (posX,posY,posZ,rotX,rotY,rotZ)
+    float pose[6];
+    if (!datparse::parseFloatList<UseFastPath>(begin, semicolon, pose, 6)) {
+        std::cerr << "Invalid pose part: " << std::string(begin, semicolon) << std::endl;
+        return false;
+    }
+    posX = pose[0]; posY = pose[1]; posZ = pose[2];
+    rotX = pose[3]; rotY = pose[4]; rotZ = pose[5];
+
+    // 2) Points, each "x,y,z" separated by ';'
+    cloud.clear();
+    const char* p = semicolon + 1;
+    while (p < end) {
+        float xyz[3];
+        const char* next = datparse::parseFloatList<UseFastPath>(p, end, xyz, 3);
+        if (next) {
+            next = datparse::skipSpaces(next, end);
+        }
+        if (next && (next == end || *next == ';')) {
+            cloud.push_back(LidarPoint{ xyz[0], xyz[1], xyz[2] });
+        } else {
+            // Empty or malformed token - resync on the next separator
+            next = static_cast<const char*>(std::memchr(p, ';', end - p));
+        }
+        if (!next || next == end) {
+            break;
+        }
+        p = next + 1;  // step over ';'
+    }
+
+    return true;
+}
+
+inline bool parseLine(const std::string& line,
+                      float& posX, float& posY, float& posZ,
+                      float& rotX, float& rotY, float& rotZ,
+                      std::vector<LidarPoint>& cloud)
+{
+    return parseLine(line.data(), line.data() + line.size(),
+                     posX, posY, posZ, rotX, rotY, rotZ, cloud);
+}
+
+#endif // DAT_PARSER_H
@@ -0,0 +1,143 @@
+#ifndef FRAME_INDEX_H
+#define FRAME_INDEX_H
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+
+// --------------------------------------------------------------------
+// Byte offset of every frame (non-empty line) in a .dat file, so the
+// emulator can seek to any frame without parsing what comes before.
+//
+// Building the index is a single memchr pass over the file. The result
+// is cached next to the data as <file>.idx and reused while the .dat
+// file's size and mtime are unchanged:
+//   FrameIndexHeader
+//   uint64_t offsets[frameCount]
+// --------------------------------------------------------------------
+static const char FRAME_INDEX_MAGIC[8] = { 'R', 'V', 'R', 'I', 'D', 'X', '1', '\0' };
+
+#pragma pack(push, 1)
+struct FrameIndexHeader {
+    char magic[8];
+    uint64_t dataSize;
+    int64_t dataMtime;
+    uint64_t frameCount;
+};
+#pragma pack(pop)
+
+inline std::string frameIndexPath(const std::string& datPath)
+{
+    return datPath + ".idx";
+}
+
+// --------------------------------------------------------------------
+// Scans the .dat file for line starts.
+// --------------------------------------------------------------------
+inline bool buildFrameIndex(const std::string& datPath, std::vector<uint64_t>& offsets)
+{
+    std::ifstream fin(datPath, std::ios::binary);
+    if (!fin.is_open()) {
+        return false;
+    }
+
+    offsets.clear();
+    std::vector<char> buffer(1 << 20);
+    uint64_t base = 0;
+    uint64_t lineStart = 0;
+    bool lineHasData = false;
+
+    while (fin) {
+        fin.read(buffer.data(), buffer.size());
+        size_t got = static_cast<size_t>(fin.gcount());
+        const char* p = buffer.data();
+        const char* end = p + got;
+
+        while (p < end) {
+            const char* nl = static_cast<const char*>(std::memchr(p, '\n', end - p));
+            if (!nl) {
+                lineHasData = lineHasData || (p < end);
+                break;
+            }
+            if (lineHasData || nl > p) {
+                offsets.push_back(lineStart);
+            }
+            lineStart = base + (nl - buffer.data()) + 1;
+            lineHasData = false;
+            p = nl + 1;
+        }
+        base += got;
+    }
+    if (lineHasData) {
+        offsets.push_back(lineStart);  // last line without a newline
+    }
+    return true;
+}
+
+// --------------------------------------------------------------------
+// Loads <file>.idx if it matches the .dat file, otherwise rebuilds it
+// and tries to refresh the cache (failure to write is not an error).
+// --------------------------------------------------------------------
+inline bool loadFrameIndex(const std::string& datPath, std::vector<uint64_t>& offsets)
+{
+    struct stat st;
+    if (stat(datPath.c_str(), &st) < 0) {
+        return false;
+    }
+
+    FrameIndexHeader expected;
+    std::memset(&expected, 0, sizeof(expected));
+    std::memcpy(expected.magic, FRAME_INDEX_MAGIC, sizeof(FRAME_INDEX_MAGIC));
+    expected.dataSize = static_cast<uint64_t>(st.st_size);
+    expected.dataMtime = static_cast<int64_t>(st.st_mtime);
+
+    const std::string idxPath = frameIndexPath(datPath);
+    struct stat idxSt;
+    if (stat(idxPath.c_str(), &idxSt) == 0) {
+        std::ifstream fin(idxPath, std::ios::binary);
+        FrameIndexHeader header;
+        // The frame count must account for the whole .idx file (and no frame
+        // is smaller than a byte), so a damaged cache is rebuilt rather than
+        // sizing a huge allocation
+        const uint64_t idxSize = static_cast<uint64_t>(idxSt.st_size);
+        if (fin.read(reinterpret_cast<char*>(&header), sizeof(header)) &&
+            std::memcmp(header.magic, expected.magic, sizeof(header.magic)) == 0 &&
+            header.dataSize == expected.dataSize &&
+            header.dataMtime == expected.dataMtime &&
+            header.frameCount <= header.dataSize &&
+            idxSize >= sizeof(header) &&
+            header.frameCount == (idxSize - sizeof(header)) / sizeof(uint64_t) &&
+            (idxSize - sizeof(header)) % sizeof(uint64_t) == 0) {
+            offsets.resize(header.frameCount);
+            if (fin.read(reinterpret_cast<char*>(offsets.data()),
+                         static_cast<std::streamsize>(offsets.size() * sizeof(uint64_t)))) {
+                return true;
+            }
+        }
+    }
+
+    if (!buildFrameIndex(datPath, offsets)) {
+        return false;
+    }
+
+    // Write to a temporary name first so concurrent readers never see a partial index
+    expected.frameCount = offsets.size();
+    const std::string tmpPath = idxPath + ".tmp";
+    std::ofstream fout(tmpPath, std::ios::binary | std::ios::trunc);
+    if (fout.write(reinterpret_cast<const char*>(&expected), sizeof(expected)) &&
+        fout.write(reinterpret_cast<const char*>(offsets.data()),
+                   static_cast<std::streamsize>(offsets.size() * sizeof(uint64_t)))) {
+        fout.close();
+        std::rename(tmpPath.c_str(), idxPath.c_str());
+    } else {
+        std::remove(tmpPath.c_str());
+    }
+    return true;
+}
+
+#endif // FRAME_INDEX_H
@@ -0,0 +1,326 @@
+#ifndef FRAME_PIPELINE_H
+#define FRAME_PIPELINE_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "frame_source.h"
+
+// --------------------------------------------------------------------
+// Read-ahead queue of ready-to-send frames for one rover.
+//
+// The producer side (produceOne) reads the next frame from the source,
+// applies the replay window (range / loop) and the rover's perturbation
+// (clone offset, noise) and publishes it in a bounded ring. The send
+// loop only pop()s finished frames, so parsing never delays a tick.
+//
+// Frames in the ring are recycled: pop() swaps the slot with the
+// caller's frame, so point buffers circulate without reallocating.
+//
+// With depth 0 there is no background producer: pop() produces the
+// frame inline, which is the old synchronous behaviour.
+//
+// Replay commands (seek, range, loop) discard whatever is queued and
+// reposition the producer, so their effect is visible on the next pop.
+// --------------------------------------------------------------------
+class FramePipeline {
+public:
+    enum class PopResult {
+        Ready,      // 'frame' holds the next frame
+        Underrun,   // producer hasn't caught up; nothing to send this tick
+        RangeEnd,   // explicit range played out (range is cleared)
+        End         // data exhausted
+    };
+
+    using Perturb = std::function<void(Frame&)>;
+
+    FramePipeline(std::unique_ptr<FrameSource> source, size_t depth, Perturb perturb, bool loop)
+        : m_source(std::move(source)), m_inline(depth == 0),
+          m_slots(std::max<size_t>(depth, 1)), m_perturb(std::move(perturb)), m_loop(loop)
+    {
+    }
+
+    uint32_t frameCount() const { return m_source->frameCount(); }
+
+    // Called by the worker that produces for this pipeline, so pop()
+    // can wake it when a slot frees up.
+    void setWakeup(std::function<void()> wakeup) { m_wakeup = std::move(wakeup); }
+
+    // ---- consumer side (send loop) ----
+
+    // True once the next pop() won't underrun
+    bool ready()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_inline || m_head != m_tail || m_ended;
+    }
+
+    PopResult pop(Frame& frame)
+    {
+        if (m_inline) {
+            produceOne();
+        }
+
+        PopResult result;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_head == m_tail) {
+                return m_ended ? PopResult::End : PopResult::Underrun;
+            }
+            Slot& slot = m_slots[m_head % m_slots.size()];
+            result = slot.result;
+            if (result == PopResult::Ready) {
+                frame.swap(slot.frame);
+                m_nextFrame = frame.index + 1;
+            }
+            ++m_head;
+            if (result == PopResult::RangeEnd) {
+                // Hold here; resuming continues after the range
+                m_rangeStart = m_rangeEnd = 0;
+                restartLocked(m_nextFrame);
+            } else if (result == PopResult::End) {
+                m_ended = true;
+            }
+        }
+        wake();
+        return result;
+    }
+
+    void seek(uint32_t frame)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            restartLocked(frame);
+        }
+        wake();
+    }
+
+    void setRange(uint32_t first, uint32_t last)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_rangeStart = first;
+            m_rangeEnd = last;
+            restartLocked(first);
+        }
+        wake();
+    }
+
+    void clearRange()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_rangeStart = m_rangeEnd = 0;
+            restartLocked(m_nextFrame);
+        }
+        wake();
+    }
+
+    void setLoop(bool loop)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_loop = loop;
+            restartLocked(m_nextFrame);
+        }
+        wake();
+    }
+
+    // ---- producer side ----
+
+    // Fills one free slot. Returns false if there was nothing to do
+    // (ring full or data exhausted).
+    bool produceOne()
+    {
+        uint32_t seekTo = 0;
+        bool mustSeek = false;
+        uint32_t rangeStart, rangeEnd;
+        bool loop;
+        uint64_t generation;
+        Slot* slot;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_producerDone || m_tail - m_head >= m_slots.size()) {
+                return false;
+            }
+            mustSeek = m_pendingSeek;
+            seekTo = m_seekFrame;
+            m_pendingSeek = false;
+            rangeStart = m_rangeStart;
+            rangeEnd = m_rangeEnd;
+            loop = m_loop;
+            generation = m_generation;
+            slot = &m_slots[m_tail % m_slots.size()];
+        }
+
+        // The slot at m_tail is invisible to the consumer until published.
+        // A seek past the last frame means "at the end" (wrap if looping)
+        bool pastEnd = mustSeek && !m_source->seek(seekTo);
+        slot->result = readFrame(slot->frame, pastEnd, rangeStart, rangeEnd, loop);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (generation != m_generation) {
+            return true;  // a command raced with us; the result is stale
+        }
+        if (slot->result != PopResult::Ready) {
+            m_producerDone = true;
+        }
+        ++m_tail;
+        return true;
+    }
+
+private:
+    struct Slot {
+        Frame frame;
+        PopResult result = PopResult::Ready;
+    };
+
+    PopResult readFrame(Frame& frame, bool pastEnd, uint32_t rangeStart, uint32_t rangeEnd, bool loop)
+    {
+        uint32_t end = (rangeEnd > 0) ? rangeEnd : m_source->frameCount();
+        if (pastEnd || m_source->position() >= end) {
+            if (loop) {
+                m_source->seek(rangeStart);
+            } else {
+                return (rangeEnd > 0) ? PopResult::RangeEnd : PopResult::End;
+            }
+        }
+        if (!m_source->next(frame)) {
+            // A source of unknown length only finds its end here
+            if (!loop || m_source->position() <= rangeStart ||
+                !m_source->seek(rangeStart) || !m_source->next(frame)) {
+                return PopResult::End;
+            }
+        }
+        frame.index = m_source->position() - 1;
+        m_perturb(frame);
+        return PopResult::Ready;
+    }
+
+    // Drops queued frames and makes the producer continue from 'frame'
+    void restartLocked(uint32_t frame)
+    {
+        m_head = m_tail;
+        m_seekFrame = frame;
+        m_pendingSeek = true;
+        m_producerDone = false;
+        m_ended = false;
+        ++m_generation;
+    }
+
+    void wake()
+    {
+        if (m_wakeup) {
+            m_wakeup();
+        }
+    }
+
+    std::unique_ptr<FrameSource> m_source;  // producer only
+    bool m_inline;
+    std::vector<Slot> m_slots;
+    Perturb m_perturb;                      // producer only
+    std::function<void()> m_wakeup;
+
+    // Everything below is guarded by m_mutex
+    std::mutex m_mutex;
+    uint64_t m_head = 0;          // next slot to pop
+    uint64_t m_tail = 0;          // next slot to fill
+    uint64_t m_generation = 0;    // bumped by every command
+    bool m_producerDone = false;  // End / RangeEnd queued
+    bool m_ended = false;         // End popped
+    bool m_pendingSeek = false;
+    uint32_t m_seekFrame = 0;
+    uint32_t m_nextFrame = 0;     // frame after the last one popped
+    bool m_loop;
+    uint32_t m_rangeStart = 0;    // replay window (m_rangeEnd == 0: whole file)
+    uint32_t m_rangeEnd = 0;
+};
+
+// --------------------------------------------------------------------
+// Background thread that keeps a set of pipelines topped up.
+//
+// One thread serves the whole fleet: it round-robins one frame at a
+// time across pipelines so a slow source can't starve the others, and
+// sleeps until a consumer frees a slot when every ring is full.
+// --------------------------------------------------------------------
+class DecodeWorker {
+public:
+    DecodeWorker() : m_thread([this] { run(); }) {}
+
+    ~DecodeWorker()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_wakeMutex);
+            m_stop = true;
+        }
+        m_wakeCv.notify_one();
+        m_thread.join();
+    }
+
+    void add(FramePipeline* pipeline)
+    {
+        pipeline->setWakeup([this] { wake(); });
+        {
+            std::lock_guard<std::mutex> lock(m_listMutex);
+            m_pipelines.push_back(pipeline);
+        }
+        wake();
+    }
+
+    // Blocks until the worker is no longer touching the pipeline
+    void remove(FramePipeline* pipeline)
+    {
+        std::lock_guard<std::mutex> lock(m_listMutex);
+        m_pipelines.erase(std::remove(m_pipelines.begin(), m_pipelines.end(), pipeline),
+                          m_pipelines.end());
+    }
+
+private:
+    void wake()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_wakeMutex);
+            m_pending = true;
+        }
+        m_wakeCv.notify_one();
+    }
+
+    void run()
+    {
+        for (;;) {
+            bool worked = false;
+            {
+                std::lock_guard<std::mutex> lock(m_listMutex);
+                for (FramePipeline* pipeline : m_pipelines) {
+                    worked |= pipeline->produceOne();
+                }
+            }
+
+            std::unique_lock<std::mutex> lock(m_wakeMutex);
+            if (!worked) {
+                m_wakeCv.wait(lock, [this] { return m_pending || m_stop; });
+            }
+            m_pending = false;
+            if (m_stop) {
+                return;
+            }
+        }
+    }
+
+    std::mutex m_listMutex;     // held while producing; see remove()
+    std::vector<FramePipeline*> m_pipelines;
+
+    std::mutex m_wakeMutex;
+    std::condition_variable m_wakeCv;
+    bool m_pending = false;
+    bool m_stop = false;
+
+    std::thread m_thread;       // last, so it starts after the members above
+};
+
+#endif // FRAME_PIPELINE_H
@@ -0,0 +1,182 @@
+#ifndef FRAME_SOURCE_H
+#define FRAME_SOURCE_H
+
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "rover_packets.h"
+#include "dat_parser.h"
+#include "scan_format.h"
+#include "frame_index.h"
+
+// --------------------------------------------------------------------
+// One replay step: the rover pose plus its LiDAR points.
+//
+// 'points' either aliases 'storage' or read-only memory owned by the
+// source (e.g. an mmapped .scan file); call makeWritable() before
+// modifying the points in place. Use swap() rather than std::swap so
+// 'points' follows the storage it aliases.
+// --------------------------------------------------------------------
+struct Frame {
+    float posX = 0, posY = 0, posZ = 0;
+    float rotX = 0, rotY = 0, rotZ = 0;
+    const LidarPoint* points = nullptr;
+    size_t numPoints = 0;
+    uint32_t index = 0;     // frame number within the source
+    uint32_t suppressed = 0;  // points removed by the sender's delta filter
+    std::vector<LidarPoint> storage;
+
+    void swap(Frame& other)
+    {
+        bool ownsPoints = (points == storage.data());
+        bool otherOwnsPoints = (other.points == other.storage.data());
+        std::swap(posX, other.posX); std::swap(posY, other.posY); std::swap(posZ, other.posZ);
+        std::swap(rotX, other.rotX); std::swap(rotY, other.rotY); std::swap(rotZ, other.rotZ);
+        std::swap(points, other.points);
+        std::swap(numPoints, other.numPoints);
+        std::swap(index, other.index);
+        std::swap(suppressed, other.suppressed);
+        storage.swap(other.storage);
+        if (ownsPoints) {
+            other.points = other.storage.data();
+        }
+        if (otherOwnsPoints) {
+            points = storage.data();
+        }
+    }
+
+    LidarPoint* makeWritable()
+    {
+        if (points != storage.data()) {
+            storage.assign(points, points + numPoints);
+            points = storage.data();
+        }
+        return storage.data();
+    }
+};
+
+// --------------------------------------------------------------------
+// Supplier of frames for one rover.
+// next() returns false at end of data. Frames are numbered from 0;
+// seek() repositions so next() returns the given frame (O(1) for files
+// with an index). A streamed source may not know its length yet and
+// reports UINT32_MAX from frameCount() until it has seen the end.
+// --------------------------------------------------------------------
+class FrameSource {
+public:
+    virtual ~FrameSource() = default;
+    virtual bool next(Frame& frame) = 0;
+
+    virtual uint32_t frameCount() const = 0;
+    virtual uint32_t position() const = 0;   // frame the next call to next() returns
+    virtual bool seek(uint32_t frame) = 0;   // false if out of range
+};
+
+// --------------------------------------------------------------------
+// Reads the original ASCII .dat format line by line.
+// Every non-empty line is a frame (see frame_index.h); malformed lines
+// are skipped.
+// --------------------------------------------------------------------
+class DatFrameSource : public FrameSource {
+public:
+    bool open(const std::string& path)
+    {
+        m_file.open(path);
+        if (!m_file.is_open()) {
+            std::cerr << "Error: cannot open data file: " << path << "\n";
+            return false;
+        }
+        if (!loadFrameIndex(path, m_offsets)) {
+            std::cerr << "Error: cannot index data file: " << path << "\n";
+            return false;
+        }
+        return true;
+    }
+
+    uint32_t frameCount() const override { return static_cast<uint32_t>(m_offsets.size()); }
+    uint32_t position() const override { return m_nextFrame; }
+
+    bool seek(uint32_t frame) override
+    {
+        if (frame >= m_offsets.size()) {
+            return false;
+        }
+        m_file.clear();
+        m_file.seekg(static_cast<std::streamoff>(m_offsets[frame]));
+        m_nextFrame = frame;
+        return static_cast<bool>(m_file);
+    }
+
+    bool next(Frame& frame) override
+    {
+        while (std::getline(m_file, m_line)) {
+            if (!m_line.empty()) {
+                ++m_nextFrame;
+            }
+            if (m_line.empty() ||
+                !parseLine(m_line, m_pose[0], m_pose[1], m_pose[2],
+                           m_pose[3], m_pose[4], m_pose[5], m_cloud)) {
+                continue;
+            }
+            frame.posX = m_pose[0]; frame.posY = m_pose[1]; frame.posZ = m_pose[2];
+            frame.rotX = m_pose[3]; frame.rotY = m_pose[4]; frame.rotZ = m_pose[5];
+            // Hand the parsed cloud over and keep the old buffer for reuse
+            frame.storage.swap(m_cloud);
+            frame.points = frame.storage.data();
+            frame.numPoints = frame.storage.size();
+            return true;
+        }
+        return false;
+    }
+
+private:
+    std::ifstream m_file;
+    std::vector<uint64_t> m_offsets;
+    uint32_t m_nextFrame = 0;
+    std::string m_line;
+    float m_pose[6] = {};
+    std::vector<LidarPoint> m_cloud;
+};
+
+// --------------------------------------------------------------------
+// Replays a memory-mapped .scan file (see scan_format.h). Points are
+// handed out in place; nothing is parsed or copied.
+// --------------------------------------------------------------------
+class ScanFrameSource : public FrameSource {
+public:
+    bool open(const std::string& path) { return m_scan.open(path); }
+
+    uint32_t frameCount() const override { return m_scan.frameCount(); }
+    uint32_t position() const override { return m_nextFrame; }
+
+    bool seek(uint32_t frame) override
+    {
+        if (frame >= m_scan.frameCount()) {
+            return false;
+        }
+        m_nextFrame = frame;
+        return true;
+    }
+
+    bool next(Frame& frame) override
+    {
+        if (m_nextFrame >= m_scan.frameCount()) {
+            return false;
+        }
+        const ScanPose& pose = m_scan.pose(m_nextFrame);
+        frame.posX = pose.posX; frame.posY = pose.posY; frame.posZ = pose.posZ;
+        frame.rotX = pose.rotX; frame.rotY = pose.rotY; frame.rotZ = pose.rotZ;
+        frame.points = m_scan.points(m_nextFrame);
+        frame.numPoints = m_scan.pointCount(m_nextFrame);
+        ++m_nextFrame;
+        return true;
+    }
+
+private:
+    ScanFile m_scan;
+    uint32_t m_nextFrame = 0;
+};
+
+#endif // FRAME_SOURCE_H
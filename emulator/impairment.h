@@ -0,0 +1,309 @@
+#ifndef IMPAIRMENT_H
+#define IMPAIRMENT_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "udp_sender.h"
+
+// --------------------------------------------------------------------
+// Simulated radio link conditions for one stream of one rover.
+//
+//   drop=P        drop each datagram with probability P
+//   burst=P       enter a loss burst with probability P per datagram...
+//   burstlen=N    ...that drops N datagrams on average (Gilbert model)
+//   dup=P         send a datagram twice with probability P
+//   reorder=N     hold up to N datagrams and release them in random order
+//   rate=R        token-bucket bandwidth cap in bit/s (k/m/g suffixes)
+//   bucket=B      burst allowance in bytes (default: 100 ms at 'rate')
+//   queue=B       bytes that may wait for tokens before tail drop
+//                 (default: 1 s at 'rate')
+// --------------------------------------------------------------------
+struct ImpairmentConfig {
+    double dropRate = 0.0;
+    double burstRate = 0.0;
+    double burstLength = 8.0;
+    double duplicateRate = 0.0;
+    size_t reorderWindow = 0;
+    double rateBitsPerSec = 0.0;  // 0 = unlimited
+    double bucketBytes = 0.0;
+    double queueBytes = 0.0;
+
+    bool enabled() const
+    {
+        return dropRate > 0.0 || burstRate > 0.0 || duplicateRate > 0.0 ||
+               reorderWindow > 0 || rateBitsPerSec > 0.0;
+    }
+};
+
+enum ImpairedStream { IMPAIR_POSE = 0, IMPAIR_LIDAR, IMPAIR_TELEM, IMPAIR_STREAM_COUNT };
+
+// --------------------------------------------------------------------
+// Parses "<stream>:key=value,..." where stream is pose, lidar, telem or
+// all, e.g. "lidar:drop=0.02,reorder=16,rate=20m". Later specs for the
+// same stream override earlier keys.
+// --------------------------------------------------------------------
+inline bool parseImpairment(const std::string& spec, ImpairmentConfig configs[IMPAIR_STREAM_COUNT])
+{
+    size_t colon = spec.find(':');
+    std::string stream = spec.substr(0, colon);
+    int first, last;
+    if (stream == "pose") {
+        first = last = IMPAIR_POSE;
+    } else if (stream == "lidar") {
+        first = last = IMPAIR_LIDAR;
+    } else if (stream == "telem") {
+        first = last = IMPAIR_TELEM;
+    } else if (stream == "all") {
+        first = IMPAIR_POSE;
+        last = IMPAIR_TELEM;
+    } else {
+        std::cerr << "Error: --impair stream must be pose, lidar, telem or all: " << spec << "\n";
+        return false;
+    }
+    if (colon == std::string::npos) {
+        std::cerr << "Error: --impair needs settings, e.g. lidar:drop=0.01\n";
+        return false;
+    }
+
+    size_t start = colon + 1;
+    while (start < spec.size()) {
+        size_t comma = spec.find(',', start);
+        std::string item = spec.substr(start, comma == std::string::npos ? std::string::npos : comma - start);
+        start = (comma == std::string::npos) ? spec.size() : comma + 1;
+
+        size_t eq = item.find('=');
+        std::string key = item.substr(0, eq);
+        const char* text = (eq == std::string::npos) ? "" : item.c_str() + eq + 1;
+        char* end = nullptr;
+        double value = std::strtod(text, &end);
+        if (end == text || value < 0.0) {
+            std::cerr << "Error: bad --impair value '" << item << "'\n";
+            return false;
+        }
+        switch (*end) {
+        case 'k': case 'K': value *= 1e3; ++end; break;
+        case 'm': case 'M': value *= 1e6; ++end; break;
+        case 'g': case 'G': value *= 1e9; ++end; break;
+        default: break;
+        }
+        bool isProbability = (key == "drop" || key == "burst" || key == "dup");
+        if (*end != '\0' || (isProbability && value > 1.0)) {
+            std::cerr << "Error: bad --impair value '" << item << "'\n";
+            return false;
+        }
+
+        for (int s = first; s <= last; ++s) {
+            ImpairmentConfig& config = configs[s];
+            if (key == "drop") {
+                config.dropRate = value;
+            } else if (key == "burst") {
+                config.burstRate = value;
+            } else if (key == "burstlen") {
+                config.burstLength = std::max(value, 1.0);
+            } else if (key == "dup") {
+                config.duplicateRate = value;
+            } else if (key == "reorder") {
+                config.reorderWindow = static_cast<size_t>(value);
+            } else if (key == "rate") {
+                config.rateBitsPerSec = value;
+            } else if (key == "bucket") {
+                config.bucketBytes = value;
+            } else if (key == "queue") {
+                config.queueBytes = value;
+            } else {
+                std::cerr << "Error: unknown --impair setting '" << item << "'\n";
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// --------------------------------------------------------------------
+// Applies an ImpairmentConfig to the datagrams of one connected socket.
+//
+// Datagrams are copied on add() (they may be held back across flushes)
+// and pass through loss, duplication, the reorder buffer and the token
+// bucket, in that order. Whatever survives is sent with one sendmmsg
+// per flush(). Tokens are only spent at flush time, so the cap is
+// enforced per send tick; datagrams waiting for tokens go out on later
+// ticks.
+//
+// The random sequence comes from 'seed' only, so a given seed and
+// traffic pattern always impair the same datagrams.
+// --------------------------------------------------------------------
+class ImpairedLink {
+public:
+    ImpairedLink(const ImpairmentConfig& config, uint64_t seed)
+        : m_config(config), m_rng(seed)
+    {
+        double bytesPerSec = m_config.rateBitsPerSec / 8.0;
+        if (m_config.bucketBytes <= 0.0) {
+            m_config.bucketBytes = bytesPerSec * 0.1;
+        }
+        if (m_config.queueBytes <= 0.0) {
+            m_config.queueBytes = bytesPerSec;
+        }
+        m_tokens = m_config.bucketBytes;
+        m_lastRefill = std::chrono::steady_clock::now();
+    }
+
+    void add(const void* head, size_t headSize, const void* body, size_t bodySize)
+    {
+        Datagram datagram = takeBuffer();
+        datagram.resize(headSize + bodySize);
+        std::memcpy(datagram.data(), head, headSize);
+        if (bodySize > 0) {
+            std::memcpy(datagram.data() + headSize, body, bodySize);
+        }
+        m_incoming.push_back(std::move(datagram));
+    }
+
+    void flush(int sock, SendStats& stats)
+    {
+        for (Datagram& datagram : m_incoming) {
+            if (lose()) {
+                stats.impairDropped++;
+                recycle(datagram);
+                continue;
+            }
+            if (m_config.duplicateRate > 0.0 && uniform() < m_config.duplicateRate) {
+                Datagram copy = takeBuffer();
+                copy.assign(datagram.begin(), datagram.end());
+                stats.impairDuplicated++;
+                reorder(std::move(copy), stats);
+            }
+            reorder(std::move(datagram), stats);
+        }
+        m_incoming.clear();
+
+        drainBucket();
+
+        for (const Datagram& datagram : m_sending) {
+            m_batch.add(datagram.data(), datagram.size(), nullptr, 0);
+        }
+        m_batch.flush(sock, stats);
+        for (Datagram& datagram : m_sending) {
+            recycle(datagram);
+        }
+        m_sending.clear();
+    }
+
+private:
+    using Datagram = std::vector<char>;
+
+    double uniform() { return static_cast<double>(m_rng() >> 11) * (1.0 / 9007199254740992.0); }
+
+    // Independent loss plus Gilbert-model bursts
+    bool lose()
+    {
+        if (m_inBurst) {
+            if (uniform() < 1.0 / m_config.burstLength) {
+                m_inBurst = false;
+            }
+            return true;
+        }
+        if (m_config.burstRate > 0.0 && uniform() < m_config.burstRate) {
+            m_inBurst = (m_config.burstLength > 1.0);
+            return true;
+        }
+        return m_config.dropRate > 0.0 && uniform() < m_config.dropRate;
+    }
+
+    // Holds up to reorderWindow datagrams, releasing a random one each
+    // time the window overflows
+    void reorder(Datagram datagram, SendStats& stats)
+    {
+        if (m_config.reorderWindow == 0) {
+            shape(std::move(datagram), stats);
+            return;
+        }
+        m_held.push_back(std::move(datagram));
+        while (m_held.size() > m_config.reorderWindow) {
+            size_t pick = static_cast<size_t>(uniform() * m_held.size());
+            if (pick != 0) {
+                stats.impairReordered++;
+            }
+            Datagram out = std::move(m_held[pick]);
+            m_held.erase(m_held.begin() + static_cast<std::ptrdiff_t>(pick));
+            shape(std::move(out), stats);
+        }
+    }
+
+    // Token bucket: queue for later, or tail-drop when the queue is full
+    void shape(Datagram datagram, SendStats& stats)
+    {
+        if (m_config.rateBitsPerSec <= 0.0) {
+            m_sending.push_back(std::move(datagram));
+            return;
+        }
+        if (m_queuedBytes + datagram.size() > m_config.queueBytes) {
+            stats.impairOverflow++;
+            recycle(datagram);
+            return;
+        }
+        m_queuedBytes += datagram.size();
+        m_waiting.push_back(std::move(datagram));
+    }
+
+    void drainBucket()
+    {
+        if (m_config.rateBitsPerSec <= 0.0) {
+            return;
+        }
+        auto now = std::chrono::steady_clock::now();
+        double seconds = std::chrono::duration<double>(now - m_lastRefill).count();
+        m_lastRefill = now;
+        m_tokens = std::min(m_config.bucketBytes, m_tokens + seconds * m_config.rateBitsPerSec / 8.0);
+
+        // A full bucket always admits one datagram, even one larger than the bucket
+        while (!m_waiting.empty() &&
+               (m_tokens >= static_cast<double>(m_waiting.front().size()) || m_tokens >= m_config.bucketBytes)) {
+            m_tokens -= static_cast<double>(m_waiting.front().size());
+            m_queuedBytes -= m_waiting.front().size();
+            m_sending.push_back(std::move(m_waiting.front()));
+            m_waiting.pop_front();
+        }
+    }
+
+    Datagram takeBuffer()
+    {
+        if (m_pool.empty()) {
+            return Datagram();
+        }
+        Datagram datagram = std::move(m_pool.back());
+        m_pool.pop_back();
+        return datagram;
+    }
+
+    void recycle(Datagram& datagram)
+    {
+        datagram.clear();
+        m_pool.push_back(std::move(datagram));
+    }
+
+    ImpairmentConfig m_config;
+    std::mt19937_64 m_rng;
+    bool m_inBurst = false;
+
+    std::vector<Datagram> m_incoming;   // added since the last flush
+    std::vector<Datagram> m_held;       // reorder window
+    std::deque<Datagram> m_waiting;     // waiting for tokens
+    size_t m_queuedBytes = 0;
+    double m_tokens = 0.0;
+    std::chrono::steady_clock::time_point m_lastRefill;
+    std::vector<Datagram> m_sending;    // released this flush
+    std::vector<Datagram> m_pool;       // spare buffers
+    DatagramBatch m_batch;
+};
+
+#endif // IMPAIRMENT_H
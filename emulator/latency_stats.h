@@ -0,0 +1,38 @@
+#ifndef LATENCY_STATS_H
+#define LATENCY_STATS_H
+
+#include <algorithm>
+#include <vector>
+
+// --------------------------------------------------------------------
+// Collected latency samples (microseconds) with summary statistics.
+// --------------------------------------------------------------------
+struct LatencySamples {
+    std::vector<double> us;
+
+    void add(double sampleUs) { us.push_back(sampleUs); }
+    void clear() { us.clear(); }
+    bool empty() const { return us.empty(); }
+
+    double mean() const
+    {
+        double sum = 0.0;
+        for (double v : us) {
+            sum += v;
+        }
+        return us.empty() ? 0.0 : sum / us.size();
+    }
+
+    // Percentile in [0,1]; sorts the samples
+    double percentile(double p)
+    {
+        if (us.empty()) {
+            return 0.0;
+        }
+        std::sort(us.begin(), us.end());
+        size_t idx = static_cast<size_t>(p * (us.size() - 1) + 0.5);
+        return us[idx];
+    }
+};
+
+#endif // LATENCY_STATS_H
@@ -0,0 +1,52 @@
+#ifndef LIDAR_ENCODING_H
+#define LIDAR_ENCODING_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+#include "rover_packets.h"
+
+// --------------------------------------------------------------------
+// Quantizes one chunk of points to int16 steps of 'resolution' meters
+// around the centre of the chunk's bounding box, filling the origin
+// and resolution fields of 'header'. Returns false (nothing usable in
+// 'out') if the chunk spans more than 65535 steps on some axis; the
+// caller then sends that chunk as float32.
+// --------------------------------------------------------------------
+inline bool quantizeChunk(const LidarPoint* points, size_t count, float resolution,
+                          LidarPacketHeader& header, LidarPointQ16* out)
+{
+    float lo[3] = { INFINITY, INFINITY, INFINITY };
+    float hi[3] = { -INFINITY, -INFINITY, -INFINITY };
+    for (size_t i = 0; i < count; ++i) {
+        lo[0] = std::min(lo[0], points[i].x); hi[0] = std::max(hi[0], points[i].x);
+        lo[1] = std::min(lo[1], points[i].y); hi[1] = std::max(hi[1], points[i].y);
+        lo[2] = std::min(lo[2], points[i].z); hi[2] = std::max(hi[2], points[i].z);
+    }
+
+    float origin[3] = { 0.0f, 0.0f, 0.0f };
+    const float maxSteps = 32000.0f;  // margin below INT16_MAX for rounding
+    for (int axis = 0; axis < 3 && count > 0; ++axis) {
+        origin[axis] = 0.5f * (lo[axis] + hi[axis]);
+        if (!(0.5f * (hi[axis] - lo[axis]) / resolution < maxSteps)) {
+            return false;
+        }
+    }
+
+    const float scale = 1.0f / resolution;
+    for (size_t i = 0; i < count; ++i) {
+        out[i].x = static_cast<int16_t>(std::lrint((points[i].x - origin[0]) * scale));
+        out[i].y = static_cast<int16_t>(std::lrint((points[i].y - origin[1]) * scale));
+        out[i].z = static_cast<int16_t>(std::lrint((points[i].z - origin[2]) * scale));
+    }
+
+    header.encoding = LIDAR_ENCODING_INT16;
+    header.originX = origin[0];
+    header.originY = origin[1];
+    header.originZ = origin[2];
+    header.resolution = resolution;
+    return true;
+}
+
+#endif // LIDAR_ENCODING_H
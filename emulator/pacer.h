@@ -0,0 +1,80 @@
+#ifndef PACER_H
+#define PACER_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+
+// --------------------------------------------------------------------
+// Token-bucket pacing for one rover's LiDAR datagrams (--pace).
+//
+// Sending a whole scan in one sendmmsg is a microburst: on loopback it
+// lands in the receiver's socket queue all at once, however rarely the
+// receiver gets to run. The pacer spreads each scan over a window (most
+// of the tick) instead: tokens (bytes) accrue at scanBytes / window, and
+// a datagram may leave once the bucket holds its size. The bucket holds
+// at most 'burst' bytes and starts each scan full, so the first burst
+// goes out at once and the rest follow every burst / rate.
+//
+// A datagram larger than the bucket leaves when the bucket is full; the
+// tokens go negative and the next one waits correspondingly longer, so
+// the average rate still holds.
+// --------------------------------------------------------------------
+class TokenBucketPacer {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit TokenBucketPacer(size_t burstBytes)
+        : m_burst(static_cast<double>(burstBytes))
+    {
+    }
+
+    // Starts pacing a scan of 'bytes' over 'window' from 'now'
+    void start(size_t bytes, Clock::time_point now, Clock::duration window)
+    {
+        double seconds = std::chrono::duration<double>(window).count();
+        m_rate = static_cast<double>(bytes) / std::max(seconds, 1e-6);
+        m_tokens = m_burst;
+        m_last = now;
+    }
+
+    // Spends the tokens for a datagram of 'size' bytes if the bucket
+    // holds them by 'now'
+    bool admit(size_t size, Clock::time_point now)
+    {
+        refill(now);
+        double need = std::min(static_cast<double>(size), m_burst);
+        if (m_tokens < need) {
+            return false;
+        }
+        m_tokens -= static_cast<double>(size);
+        return true;
+    }
+
+    // When admit() will accept a datagram of 'size' bytes
+    Clock::time_point readyAt(size_t size) const
+    {
+        double need = std::min(static_cast<double>(size), m_burst) - m_tokens;
+        if (need <= 0.0) {
+            return m_last;
+        }
+        return m_last + std::chrono::ceil<Clock::duration>(std::chrono::duration<double>(need / m_rate));
+    }
+
+private:
+    void refill(Clock::time_point now)
+    {
+        double seconds = std::chrono::duration<double>(now - m_last).count();
+        if (seconds > 0.0) {
+            m_tokens = std::min(m_burst, m_tokens + seconds * m_rate);
+            m_last = now;
+        }
+    }
+
+    double m_burst;          // bucket size in bytes
+    double m_rate = 0.0;     // bytes per second for the current scan
+    double m_tokens = 0.0;
+    Clock::time_point m_last;
+};
+
+#endif // PACER_H
@@ -0,0 +1,191 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+#include <iomanip>
+
+#include "rover_packets.h"
+#include "dat_parser.h"
+
+// --------------------------------------------------------------------
+// Parser throughput benchmark.
+//
+// Loads a .dat file into memory and times three parsers over it:
+//   legacy     - the original splitString + std::stof parseLine
+//   from_chars - the streaming parser without the SWAR fast path
+//   fast       - the streaming parser as used by the emulator
+// File I/O is excluded; every parser sees the same in-memory lines.
+// --------------------------------------------------------------------
+
+// --------------------------------------------------------------------
+// The original implementation, kept verbatim as the baseline.
+// --------------------------------------------------------------------
+static std::vector<std::string> splitString(const std::string& s, char delim)
+{
+    std::vector<std::string> tokens;
+    size_t start = 0;
+    while (true) {
+        size_t pos = s.find(delim, start);
+        if (pos == std::string::npos) {
+            tokens.push_back(s.substr(start));
+            break;
+        }
+        tokens.push_back(s.substr(start, pos - start));
+        start = pos + 1;
+    }
+    return tokens;
+}
+
+static bool legacyParseLine(const std::string& line,
+                            float& posX, float& posY, float& posZ,
+                            float& rotX, float& rotY, float& rotZ,
+                            std::vector<LidarPoint>& cloud)
+{
+    size_t semicolonPos = line.find(';');
+    if (semicolonPos == std::string::npos) {
+        return false;
+    }
+
+    std::string posePart = line.substr(0, semicolonPos);
+    std::string pointsPart = line.substr(semicolonPos + 1);
+
+    {
+        std::vector<std::string> poseTokens = splitString(posePart, ',');
+        if (poseTokens.size() < 6) {
+            return false;
+        }
+        posX = std::stof(poseTokens[0]);
+        posY = std::stof(poseTokens[1]);
+        posZ = std::stof(poseTokens[2]);
+        rotX = std::stof(poseTokens[3]);
+        rotY = std::stof(poseTokens[4]);
+        rotZ = std::stof(poseTokens[5]);
+    }
+
+    std::vector<std::string> pointTokens = splitString(pointsPart, ';');
+    cloud.clear();
+    cloud.reserve(pointTokens.size());
+
+    for (const auto& pt : pointTokens) {
+        std::vector<std::string> coords = splitString(pt, ',');
+        if (coords.size() < 3) {
+            continue;
+        }
+        LidarPoint p;
+        p.x = std::stof(coords[0]);
+        p.y = std::stof(coords[1]);
+        p.z = std::stof(coords[2]);
+        cloud.push_back(p);
+    }
+
+    return true;
+}
+
+struct BenchResult {
+    double seconds = 0.0;
+    uint64_t points = 0;
+    uint64_t checksum = 0;  // FNV-1a over every parsed float, to compare outputs
+};
+
+static void hashBytes(uint64_t& h, const void* data, size_t size)
+{
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        h = (h ^ bytes[i]) * 1099511628211ULL;
+    }
+}
+
+template <typename ParseFn>
+static BenchResult runParser(const std::vector<std::string>& lines, ParseFn parse)
+{
+    BenchResult result;
+    std::vector<LidarPoint> cloud;
+    float pose[6];
+
+    // Untimed warm-up so the reused vector reaches its working size
+    for (size_t i = 0; i < lines.size() && i < 16; ++i) {
+        parse(lines[i], pose, cloud);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (const auto& line : lines) {
+        if (parse(line, pose, cloud)) {
+            result.points += cloud.size();
+        }
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // Checksum pass (untimed)
+    result.checksum = 14695981039346656037ULL;
+    for (const auto& line : lines) {
+        if (parse(line, pose, cloud)) {
+            hashBytes(result.checksum, pose, sizeof(pose));
+            hashBytes(result.checksum, cloud.data(), cloud.size() * sizeof(LidarPoint));
+        }
+    }
+    return result;
+}
+
+static void report(const char* name, const BenchResult& r, double megabytes, const BenchResult* baseline)
+{
+    std::cout << std::left << std::setw(12) << name << std::right << std::fixed
+              << std::setprecision(3) << std::setw(9) << r.seconds << " s"
+              << std::setprecision(1) << std::setw(10) << (megabytes / r.seconds) << " MB/s"
+              << std::setprecision(2) << std::setw(10) << (r.points / r.seconds / 1e6) << " Mpoints/s";
+    if (baseline) {
+        std::cout << std::setprecision(1) << std::setw(8) << (baseline->seconds / r.seconds) << "x";
+        std::cout << (r.checksum == baseline->checksum ? "  (output identical)" : "  (OUTPUT DIFFERS)");
+    }
+    std::cout << "\n";
+}
+
+int main(int argc, char** argv)
+{
+    std::string path = (argc >= 2) ? argv[1] : "data/rover2.dat";
+    size_t maxLines = (argc >= 3) ? std::strtoul(argv[2], nullptr, 10) : 0;
+
+    std::ifstream fin(path);
+    if (!fin.is_open()) {
+        std::cerr << "Error: cannot open data file: " << path << "\n";
+        std::cerr << "Usage: " << argv[0] << " [file.dat] [maxLines]\n";
+        return 1;
+    }
+
+    std::vector<std::string> lines;
+    uint64_t bytes = 0;
+    std::string line;
+    while (std::getline(fin, line)) {
+        if (line.empty()) {
+            continue;
+        }
+        bytes += line.size() + 1;
+        lines.push_back(std::move(line));
+        if (maxLines > 0 && lines.size() >= maxLines) {
+            break;
+        }
+    }
+    double megabytes = bytes / (1024.0 * 1024.0);
+    std::cout << path << ": " << lines.size() << " lines, "
+              << std::fixed << std::setprecision(1) << megabytes << " MB\n\n";
+
+    BenchResult legacy = runParser(lines, [](const std::string& l, float* pose, std::vector<LidarPoint>& cloud) {
+        return legacyParseLine(l, pose[0], pose[1], pose[2], pose[3], pose[4], pose[5], cloud);
+    });
+    BenchResult fromChars = runParser(lines, [](const std::string& l, float* pose, std::vector<LidarPoint>& cloud) {
+        return parseLine<false>(l.data(), l.data() + l.size(),
+                                pose[0], pose[1], pose[2], pose[3], pose[4], pose[5], cloud);
+    });
+    BenchResult fast = runParser(lines, [](const std::string& l, float* pose, std::vector<LidarPoint>& cloud) {
+        return parseLine<true>(l.data(), l.data() + l.size(),
+                               pose[0], pose[1], pose[2], pose[3], pose[4], pose[5], cloud);
+    });
+
+    report("legacy", legacy, megabytes, nullptr);
+    report("from_chars", fromChars, megabytes, &legacy);
+    report("fast", fast, megabytes, &legacy);
+
+    return (fromChars.checksum == legacy.checksum && fast.checksum == legacy.checksum) ? 0 : 2;
+}
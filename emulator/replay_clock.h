@@ -0,0 +1,103 @@
+#ifndef REPLAY_CLOCK_H
+#define REPLAY_CLOCK_H
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <time.h>
+
+#include "latency_stats.h"
+
+// --------------------------------------------------------------------
+// Tick timing for the interval since the last reset().
+// Lateness is how long after its deadline a tick actually woke up.
+// --------------------------------------------------------------------
+struct TickStats {
+    uint64_t ticks = 0;
+    uint64_t overruns = 0;     // ticks whose work ran past the next deadline
+    LatencySamples lateness;   // one sample per throttled tick, if sampled
+
+    void reset() { *this = TickStats(); }
+};
+
+// --------------------------------------------------------------------
+// Drift-free replay clock.
+//
+// Deadlines sit on a fixed grid (start + n * period) on CLOCK_MONOTONIC
+// and are slept to with clock_nanosleep(TIMER_ABSTIME), so time spent
+// parsing and sending never stretches the period. rate scales replay
+// speed (2.0 = twice as fast); rate <= 0 disables sleeping entirely.
+// Lateness samples are only kept with sampleLateness, as nothing else
+// reads them.
+// A tick that overruns skips the missed grid slots instead of bursting
+// to catch up.
+// --------------------------------------------------------------------
+class ReplayClock {
+public:
+    ReplayClock(double basePeriodSeconds, double rate, bool sampleLateness)
+        : m_throttled(rate > 0.0),
+          m_sampleLateness(sampleLateness),
+          m_periodNs(rate > 0.0 ? std::max<int64_t>(1, static_cast<int64_t>(basePeriodSeconds * 1e9 / rate)) : 0)
+    {
+    }
+
+    bool throttled() const { return m_throttled; }
+
+    void start()
+    {
+        m_deadlineNs = nowNs();
+    }
+
+    // Blocks until the next tick is due.
+    void waitNextTick()
+    {
+        ++m_stats.ticks;
+        if (!m_throttled) {
+            return;
+        }
+
+        m_deadlineNs += m_periodNs;
+        int64_t now = nowNs();
+        if (now > m_deadlineNs) {
+            // Overran: move to the next grid slot still in the future
+            int64_t missed = (now - m_deadlineNs) / m_periodNs + 1;
+            m_deadlineNs += missed * m_periodNs;
+            m_stats.overruns++;
+        }
+
+        timespec ts;
+        ts.tv_sec = static_cast<time_t>(m_deadlineNs / 1000000000LL);
+        ts.tv_nsec = static_cast<long>(m_deadlineNs % 1000000000LL);
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {
+        }
+
+        if (m_sampleLateness) {
+            m_stats.lateness.add((nowNs() - m_deadlineNs) / 1000.0);
+        }
+    }
+
+    // When the next tick is due, unless this one overruns
+    std::chrono::steady_clock::time_point nextTickTime() const
+    {
+        return std::chrono::steady_clock::now() + std::chrono::nanoseconds(m_deadlineNs + m_periodNs - nowNs());
+    }
+
+    TickStats& stats() { return m_stats; }
+
+private:
+    static int64_t nowNs()
+    {
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+    }
+
+    bool m_throttled;
+    bool m_sampleLateness;
+    int64_t m_periodNs;
+    int64_t m_deadlineNs = 0;
+    TickStats m_stats;
+};
+
+#endif // REPLAY_CLOCK_H
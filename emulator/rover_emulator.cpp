@@ -1,372 +1,1300 @@
 #include <iostream>
-#include <fstream>
 #include <string>
 #include <vector>
 #include <chrono>
-#include <thread>
 #include <map>
 #include <cstring>
 #include <cstdlib>
+#include <cstdio>
+#include <cstdint>
+#include <csignal>
+#include <iomanip>
 #include <arpa/inet.h>
 #include <sys/socket.h>
 #include <unistd.h>
 #include <random>
+#include <cmath>
+#include <memory>
+#include <thread>
 
 #include "rover_profiles.h"
-
-#define LOOPBACK_ADDR "127.0.0.1"
+#include "rover_packets.h"
+#include "frame_source.h"
+#include "frame_pipeline.h"
+#include "archive_source.h"
+#include "impairment.h"
+#include "lidar_encoding.h"
+#include "voxel_filter.h"
+#include "shm_ring.h"
+#include "pacer.h"
+#include "udp_sender.h"
+#include "replay_clock.h"
+#include "noise.h"
 
 // --------------------------------------------------------------------
-// Simple function to create a UDP socket (IPv4, non-blocking).
+// Parses a rover ID list: "3", "1-200" or "1,2,7-9".
 // --------------------------------------------------------------------
-int createUDPSocket()
+bool parseRoverIds(const std::string& spec, std::vector<int>& ids)
 {
-    int sock = socket(AF_INET, SOCK_DGRAM, 0);
-    if (sock < 0) {
-        std::cerr << "Error: cannot create UDP socket.\n";
-        std::exit(EXIT_FAILURE);
-    }
-    return sock;
-}
+    size_t start = 0;
+    while (start <= spec.size()) {
+        size_t comma = spec.find(',', start);
+        std::string item = spec.substr(start, comma == std::string::npos ? std::string::npos : comma - start);
 
-// --------------------------------------------------------------------
-// Sends a buffer via UDP to the specified port on localhost (127.0.0.1).
-// Returns number of bytes sent, or -1 on error.
-// --------------------------------------------------------------------
-ssize_t sendUDP(int sock, const void* data, size_t dataSize, int port)
-{
-    sockaddr_in addr;
-    std::memset(&addr, 0, sizeof(addr));
-    addr.sin_family = AF_INET;
-    addr.sin_port = htons(port);
-    addr.sin_addr.s_addr = inet_addr(LOOPBACK_ADDR);
-
-    return sendto(sock, data, dataSize, 0,
-                  reinterpret_cast<sockaddr*>(&addr),
-                  sizeof(addr));
-}
+        char* end = nullptr;
+        long first = std::strtol(item.c_str(), &end, 10);
+        long last = first;
+        if (*end == '-') {
+            last = std::strtol(end + 1, &end, 10);
+        }
+        if (item.empty() || *end != '\0' || first < 1 || last < first || last > MAX_ROVER_ID) {
+            std::cerr << "Error: invalid rover ID list '" << spec
+                      << "' (IDs must be 1.." << MAX_ROVER_ID << ")\n";
+            return false;
+        }
+        for (long id = first; id <= last; ++id) {
+            ids.push_back(static_cast<int>(id));
+        }
 
-// --------------------------------------------------------------------
-// Helper: splits a string by delimiter (returns vector of tokens).
-// --------------------------------------------------------------------
-std::vector<std::string> splitString(const std::string& s, char delim)
-{
-    std::vector<std::string> tokens;
-    size_t start = 0;
-    while (true) {
-        size_t pos = s.find(delim, start);
-        if (pos == std::string::npos) {
-            tokens.push_back(s.substr(start));
+        if (comma == std::string::npos) {
             break;
         }
-        tokens.push_back(s.substr(start, pos - start));
-        start = pos + 1;
+        start = comma + 1;
     }
-    return tokens;
+    return true;
 }
 
 // --------------------------------------------------------------------
-// Pose packet structure.
+// Settings shared by every rover in this process.
 // --------------------------------------------------------------------
-#pragma pack(push, 1)
-struct PosePacket {
-    double timestamp;
-    float posX;
-    float posY;
-    float posZ;
-    float rotXdeg;
-    float rotYdeg;
-    float rotZdeg;
+struct EmulatorOptions {
+    bool noNoise = false;
+    bool useBinary = false;
+    float cloneSpacing = 500.0f;  // meters between cloned fleets
+    bool printStats = false;
+    double rate = 1.0;            // replay speed multiplier, <= 0 = unthrottled
+    bool loop = false;            // restart at end of data instead of finishing
+    size_t readahead = 4;         // decoded frames queued per rover, 0 = decode inline
+    uint64_t seed = 0;            // noise (and impairment) seed for the whole run
+    ImpairmentConfig impair[IMPAIR_STREAM_COUNT];  // simulated link per stream
+    float quantizeResolution = 0.0f;  // LiDAR int16 step in meters, 0 = send floats
+    size_t chunkBytes = 0;        // LiDAR datagram size limit, 0 = path MTU
+    float deltaVoxel = 0.0f;      // delta filter voxel size in meters, 0 = full scans
+    double deltaWindow = 5.0;     // seconds of data a sent voxel stays suppressed
+    bool sharedMemory = false;    // same-host shm ring per rover, UDP while no reader
+    bool multiplexed = false;     // all streams to INGEST_PORT behind a MuxHeader
+    bool statePackets = false;    // pose + telemetry as one StatePacket per tick
+    size_t paceBurstBytes = 0;    // LiDAR spread over the frame in bursts this big, 0 = at once
+    double poseHz = 10.0;         // per-stream send rates in replay time (scaled by --rate)
+    double lidarHz = 10.0;
+    double telemHz = 10.0;
 };
-#pragma pack(pop)
+
+// Rate of the logged frames; a LiDAR scan can't be sent more often
+static const double DATA_FRAME_HZ = 10.0;
 
 // --------------------------------------------------------------------
-// LiDAR packet structure
+// What is due on one replay tick.
+//
+// The clock ticks at the fastest of the stream rates and the frame
+// rate. A slower stream fires on the ticks where its own count of
+// periods advances, so a rate that doesn't divide the tick rate jitters
+// by up to one tick. With the default 10 Hz everywhere every tick
+// carries a frame, a pose, a scan and a telemetry packet.
 // --------------------------------------------------------------------
-static const size_t MAX_LIDAR_POINTS_PER_PACKET = 100;
-
-#pragma pack(push, 1)
-struct LidarPacketHeader {
-    double timestamp;
-    uint32_t chunkIndex;
-    uint32_t totalChunks;
-    uint32_t pointsInThisChunk;
+struct TickPlan {
+    bool frame = false;       // advance to the next logged frame
+    bool pose = false;        // pose (or state packet with --state)
+    bool lidar = false;       // scan of the current frame, if not sent yet
+    bool telem = false;
+    float frameAlpha = 0.0f;  // how far into the current frame period, 0..1
 };
 
-// Each point is 3 floats
-struct LidarPoint {
-    float x;
-    float y;
-    float z;
-};
+class StreamSchedule {
+public:
+    explicit StreamSchedule(const EmulatorOptions& options)
+        : m_options(options),
+          m_tickHz(std::max({ DATA_FRAME_HZ, options.poseHz, options.lidarHz, options.telemHz }))
+    {
+    }
 
-struct LidarPacket {
-    LidarPacketHeader header;
-    LidarPoint points[MAX_LIDAR_POINTS_PER_PACKET];
-};
+    double tickHz() const { return m_tickHz; }
 
-struct VehicleTelem {
-    double timestamp;
-    uint8_t buttonStates;  // bits 0..3 represent buttons 0..3
+    // Plan for the next tick
+    TickPlan next()
+    {
+        TickPlan plan;
+        plan.frame = due(DATA_FRAME_HZ);
+        plan.pose = due(m_options.poseHz);
+        plan.lidar = due(m_options.lidarHz);
+        plan.telem = due(m_options.telemHz);
+        // Time since the current frame was due, in frame periods
+        int64_t frame = events(DATA_FRAME_HZ, m_tick + 1) - 1;
+        double sinceFrame = periods(DATA_FRAME_HZ, m_tick) - static_cast<double>(frame);
+        plan.frameAlpha = static_cast<float>(std::max(0.0, std::min(sinceFrame, 1.0)));
+        ++m_tick;
+        return plan;
+    }
+
+private:
+    // Periods of a 'hz' stream elapsed when tick 'tick' starts
+    double periods(double hz, int64_t tick) const
+    {
+        return static_cast<double>(tick) * hz / m_tickHz;
+    }
+
+    // Events of a 'hz' stream (one at the start of each period) before
+    // tick 'tick' starts
+    int64_t events(double hz, int64_t tick) const
+    {
+        return static_cast<int64_t>(std::ceil(periods(hz, tick) - 1e-9));
+    }
+
+    // Whether an event falls into the current tick
+    bool due(double hz) const
+    {
+        return events(hz, m_tick + 1) > events(hz, m_tick);
+    }
+
+    const EmulatorOptions& m_options;
+    double m_tickHz;
+    int64_t m_tick = 0;
 };
-#pragma pack(pop)
+
+// Standard deviation of the injected pose and point noise
+static const float NOISE_SIGMA = 0.5f;
+
+// Share of a frame period a paced scan is spread over; the rest is
+// slack for late wakeups, so a scan normally finishes before the next
+// frame replaces the points it is sent from
+static const double PACE_FRAME_FRACTION = 0.8;
 
 // --------------------------------------------------------------------
-// parseLine: Given a single line from the data file, parse the pose
-// and the list of LiDAR points.
+// Replay state for one rover: its data source, current frame, button
+// states, command socket and connected send sockets (one per stream, or
+// a single one to INGEST_PORT with --mux). step() performs one replay
+// tick (see TickPlan); with --pace, paceLidar() sends the rest of the
+// scan in between.
+//
+// The frame after the current one is fetched ahead of time, so a pose
+// rate above the frame rate can interpolate toward it.
+//
+// Frames come from a FramePipeline: reading, parsing, the replay window
+// and noise all happen on the producer side (the decode worker unless
+// --readahead 0), so step() only serializes and sends.
 //
-// Format: posX,posY,posZ,rotX,rotY,rotZ; x1,y1,z1; x2,y2,z2; ...
+// The command port accepts a single byte (button states, as sent by
+// the visualization) or a text command:
+//   seek <frame>       jump to a frame (10 frames per second of data)
+//   seek <seconds>s    jump to a point in time, e.g. "seek 300s"
+//   loop on|off        restart at the end of data / range
+//   range <a> <b>      replay frames [a, b); pauses at b unless looping
+//   range off          clear the range
 // --------------------------------------------------------------------
-bool parseLine(const std::string& line,
-               float& posX, float& posY, float& posZ,
-               float& rotX, float& rotY, float& rotZ,
-               std::vector<LidarPoint>& cloud)
-{
-    // 1) Split at the first semicolon to separate "pose" from "points"
-    size_t semicolonPos = line.find(';');
-    if (semicolonPos == std::string::npos) {
-        std::cerr << "Invalid line (no semicolon): " << line << std::endl;
-        return false;
+class RoverSim {
+public:
+    RoverSim(int id, const RoverProfile& profile, const EmulatorOptions& options)
+        : m_id(id), m_profile(profile), m_options(options)
+    {
     }
 
-    std::string posePart = line.substr(0, semicolonPos);
-    std::string pointsPart = line.substr(semicolonPos + 1);
+    ~RoverSim()
+    {
+        for (int sock : { m_cmdSock, m_poseSock }) {
+            if (sock >= 0) {
+                close(sock);
+            }
+        }
+        // With --mux these are the pose socket
+        for (int sock : { m_lidarSock, m_telemSock }) {
+            if (sock >= 0 && sock != m_poseSock) {
+                close(sock);
+            }
+        }
+    }
+
+    int id() const { return m_id; }
+
+    FramePipeline& pipeline() { return *m_pipeline; }
 
-    // 2) Parse the pose part (posX,posY,posZ,rotX,rotY,rotZ)
+    size_t lidarDatagramBytes() const { return m_lidarDatagramBytes; }
+
+    bool init()
     {
-        std::vector<std::string> poseTokens = splitString(posePart, ',');
-        if (poseTokens.size() < 6) {
-            std::cerr << "Invalid pose part: " << posePart << std::endl;
+        // Open the data file: either the ASCII .dat or its converted .scan
+        std::unique_ptr<FrameSource> source;
+        if (m_options.useBinary) {
+            auto scanSource = std::make_unique<ScanFrameSource>();
+            if (!scanSource->open(scanFilePath(m_profile.dataFile))) {
+                std::cerr << "Hint: run 'make convert' to build the .scan files\n";
+                return false;
+            }
+            source = std::move(scanSource);
+        } else if (access(m_profile.dataFile.c_str(), F_OK) != 0 &&
+                   access(archivePath().c_str(), F_OK) == 0) {
+            // Not extracted: decompress the archive on the fly
+            auto archiveSource = std::make_unique<ArchiveFrameSource>();
+            std::string member = m_profile.dataFile.substr(m_profile.dataFile.find_last_of('/') + 1);
+            if (!archiveSource->open(archivePath(), member)) {
+                return false;
+            }
+            source = std::move(archiveSource);
+        } else {
+            auto datSource = std::make_unique<DatFrameSource>();
+            if (!datSource->open(m_profile.dataFile)) {
+                return false;
+            }
+            source = std::move(datSource);
+        }
+        m_pipeline = std::make_unique<FramePipeline>(
+            std::move(source), m_options.readahead,
+            [this](Frame& frame) { perturbFrame(frame); }, m_options.loop);
+
+        // Listen for button commands on cmdPort on localhost
+        m_cmdSock = createUDPSocket();
+        sockaddr_in cmdAddr;
+        std::memset(&cmdAddr, 0, sizeof(cmdAddr));
+        cmdAddr.sin_family = AF_INET;
+        cmdAddr.sin_port   = htons(m_profile.cmdPort);
+        cmdAddr.sin_addr.s_addr = inet_addr(LOOPBACK_ADDR);
+
+        if (bind(m_cmdSock, reinterpret_cast<sockaddr*>(&cmdAddr), sizeof(cmdAddr)) < 0) {
+            std::cerr << "Error: cannot bind command socket on port " << m_profile.cmdPort << "\n";
             return false;
         }
-        posX = std::stof(poseTokens[0]);
-        posY = std::stof(poseTokens[1]);
-        posZ = std::stof(poseTokens[2]);
-        rotX = std::stof(poseTokens[3]);
-        rotY = std::stof(poseTokens[4]);
-        rotZ = std::stof(poseTokens[5]);
+
+        // One connected socket per stream, or one for all of them
+        if (m_options.multiplexed) {
+            m_poseSock = m_lidarSock = m_telemSock = connectUDPSocket(INGEST_PORT);
+            m_muxHeader.magic = MUX_MAGIC;
+            m_muxHeader.version = MUX_PROTOCOL_VERSION;
+            m_muxHeader.roverId = static_cast<uint32_t>(m_id);
+        } else {
+            m_poseSock  = connectUDPSocket(m_profile.posePort);
+            m_lidarSock = connectUDPSocket(m_profile.lidarPort);
+            m_telemSock = connectUDPSocket(m_profile.telemPort);
+        }
+        if (m_lidarSock >= 0) {
+            m_lidarDatagramBytes = m_options.chunkBytes ? m_options.chunkBytes : pathDatagramLimit(m_lidarSock);
+        }
+
+        // Shared memory is optional: without it every stream stays on UDP
+        if (m_options.sharedMemory) {
+            m_ring = std::make_unique<ShmRingWriter>();
+            if (!m_ring->create(shmRingName(m_id))) {
+                std::cerr << "Rover " << m_id << ": shared memory unavailable, using UDP\n";
+                m_ring.reset();
+            }
+        }
+
+        if (m_options.paceBurstBytes > 0 && m_options.rate > 0.0) {
+            m_pacer = std::make_unique<TokenBucketPacer>(m_options.paceBurstBytes);
+            m_paceWindow = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                std::chrono::duration<double>(1.0 / (DATA_FRAME_HZ * m_options.rate) * PACE_FRAME_FRACTION));
+        }
+
+        if (m_options.deltaVoxel > 0.0f) {
+            uint32_t windowFrames = static_cast<uint32_t>(std::max(1.0, m_options.deltaWindow * 10.0));
+            m_delta = std::make_unique<VoxelDeltaFilter>(m_options.deltaVoxel, windowFrames);
+        }
+
+        // Optional simulated link conditions, seeded per rover and stream
+        for (int stream = 0; stream < IMPAIR_STREAM_COUNT; ++stream) {
+            if (m_options.impair[stream].enabled()) {
+                uint64_t mix = m_options.seed ^ (static_cast<uint64_t>(m_id) << 32) ^ (0xA5A5ULL << stream);
+                m_links[stream] = std::make_unique<ImpairedLink>(m_options.impair[stream],
+                                                                 NoiseGenerator::splitMix64(mix));
+            }
+        }
+        return m_poseSock >= 0 && m_lidarSock >= 0 && m_telemSock >= 0;
     }
 
-    // 3) Parse the rest of the line for points, each separated by ';'
-    std::vector<LidarPoint> pointTokens_parsed;
-    std::vector<std::string> pointTokens = splitString(pointsPart, ';');
-    cloud.clear();
-    cloud.reserve(pointTokens.size());
+    // Returns false once the rover's data is exhausted. tickStart is
+    // when the current tick began, for the pose delay statistic.
+    bool step(const TickPlan& plan, double timestamp, std::chrono::steady_clock::time_point tickStart,
+              SendStats& stats)
+    {
+        pollCommands();
 
-    for (const auto& pt : pointTokens) {
-        // Each pt is "x,y,z"
-        std::vector<std::string> coords = splitString(pt, ',');
-        if (coords.size() < 3) {
-            // Possibly last empty token?
-            continue;
+        // Decided once per tick so a scan never straddles both transports
+        m_ringActive = m_ring && m_ring->readerAttached();
+
+        // Only take new data if engine is running (bit 0)
+        if (engineRunning()) {
+            if (!m_hasNext && !m_ended) {
+                fetchNext();
+            }
+            if (plan.frame) {
+                if (m_hasNext) {
+                    advanceFrame(stats);
+                } else if (m_ended) {
+                    // End of file - this rover is done
+                    return false;
+                } else {
+                    // Decoder is behind: repeat the pose, skip this frame's LiDAR
+                    stats.underruns++;
+                }
+            }
+        }
+        // When engine is stopped, we don't take new frames - data stays at last position
+
+        auto sendStart = std::chrono::steady_clock::now();
+
+        // Send pose data if we have it (even when paused, send last known
+        // position); with --state it travels with the button states
+        if (plan.pose) {
+            if (m_options.statePackets) {
+                sendState(timestamp, plan.frameAlpha, stats);
+            } else if (m_hasData) {
+                sendPose(timestamp, plan.frameAlpha, stats);
+            }
+            // Samples are only kept for --stats to print
+            if (m_hasData && m_options.printStats) {
+                stats.poseDelay.add(std::chrono::duration<double, std::micro>(
+                    std::chrono::steady_clock::now() - tickStart).count());
+            }
         }
-        LidarPoint p;
-        p.x = std::stof(coords[0]);
-        p.y = std::stof(coords[1]);
-        p.z = std::stof(coords[2]);
-        cloud.push_back(p);
+
+        // Each frame's scan is sent at most once, on the first LiDAR tick
+        // after it arrived (don't accumulate points when paused)
+        if (plan.lidar && m_lidarPending) {
+            m_lidarPending = false;
+            filterFrame(m_frame);
+            sendLidar(timestamp, stats);
+        }
+
+        // Always send telemetry (so visualization knows button state)
+        if (plan.telem && !m_options.statePackets) {
+            VehicleTelem telem;
+            telem.timestamp    = timestamp;
+            telem.buttonStates = m_buttonStates;
+            telem.sequence     = m_telemSequence++;
+            toWire(telem);
+            sendSingle(IMPAIR_TELEM, m_telemSock, MUX_STREAM_TELEM, &telem, sizeof(telem), stats);
+        }
+
+        stats.frames++;
+        stats.sendMicros += std::chrono::duration<double, std::micro>(
+            std::chrono::steady_clock::now() - sendStart).count();
+        return true;
     }
 
-    return true;
-}
+    // --pace: sends the queued LiDAR chunks the pacer admits by 'now'.
+    // Returns when the next one is due, time_point::max() if none is left.
+    std::chrono::steady_clock::time_point paceLidar(std::chrono::steady_clock::time_point now, SendStats& stats)
+    {
+        if (!m_pacer || m_unsentChunk >= m_chunks.size()) {
+            return std::chrono::steady_clock::time_point::max();
+        }
+        size_t first = m_unsentChunk;
+        while (m_unsentChunk < m_chunks.size() && m_pacer->admit(chunkBytes(m_chunks[m_unsentChunk]), now)) {
+            queueChunk(m_chunks[m_unsentChunk++]);
+        }
+        if (m_unsentChunk > first) {
+            flushLidar(stats);
+            stats.pacedBursts++;
+        }
+        if (m_unsentChunk >= m_chunks.size()) {
+            return std::chrono::steady_clock::time_point::max();
+        }
+        return m_pacer->readyAt(chunkBytes(m_chunks[m_unsentChunk]));
+    }
 
-int main(int argc, char** argv)
-{
-    if (argc < 2) {
-        std::cerr << "Usage: " << argv[0] << " <ROVER_ID>\n";
-        return 1;
+private:
+    std::string archivePath() const { return m_profile.dataFile + ".tar.xz"; }
+
+    bool engineRunning() const { return (m_buttonStates & 0x01) != 0; }
+
+    // Pops the frame after the current one into m_next
+    void fetchNext()
+    {
+        switch (m_pipeline->pop(m_next)) {
+        case FramePipeline::PopResult::Ready:
+            m_hasNext = true;
+            break;
+        case FramePipeline::PopResult::Underrun:
+            break;  // retried next tick
+        case FramePipeline::PopResult::RangeEnd:
+            // Explicit range played out: hold the last frame
+            std::cout << "Rover " << m_id << " reached end of range at frame "
+                      << m_frame.index + 1 << "\n";
+            setButtonStates(m_buttonStates & ~0x01);
+            break;
+        case FramePipeline::PopResult::End:
+            m_ended = true;
+            break;
+        }
     }
-    std::string roverID = argv[1];
 
-    // Look up the rover's profile
-    auto it = g_roverProfiles.find(roverID);
-    if (it == g_roverProfiles.end()) {
-        std::cerr << "Error: No profile found for rover ID: " << roverID << "\n";
-        return 1;
+    // Makes the fetched frame current and fetches the one after it
+    void advanceFrame(SendStats& stats)
+    {
+        // Paced chunks still queued go out now, while the frame they
+        // point into is still current
+        if (m_unsentChunk < m_chunks.size()) {
+            stats.pacedLate += m_chunks.size() - m_unsentChunk;
+            while (m_unsentChunk < m_chunks.size()) {
+                queueChunk(m_chunks[m_unsentChunk++]);
+            }
+            flushLidar(stats);
+        }
+        m_frame.swap(m_next);
+        m_hasNext = false;
+        m_hasData = true;
+        m_lidarPending = true;
+        fetchNext();
     }
-    RoverProfile profile = it->second;
 
-    bool noNoise = false;
-    for (int i = 2; i < argc; i++) {
-        if (std::string(argv[i]) == "--no-noise") {
-            noNoise = true;
+    // Replay commands reposition the pipeline; the frame fetched ahead
+    // belongs to the old position
+    void discardNext()
+    {
+        m_hasNext = false;
+        m_ended = false;
+    }
+
+    // Fills the pose fields of a PosePacket or StatePacket for this tick:
+    // the current frame's pose or, part way through the frame period,
+    // interpolated toward the next frame. Only consecutive frames are
+    // interpolated, so a seek or a loop jumps instead of gliding.
+    template <typename Packet>
+    void fillPose(Packet& packet, float alpha) const
+    {
+        packet.posX = m_frame.posX;
+        packet.posY = m_frame.posY;
+        packet.posZ = m_frame.posZ;
+        packet.rotXdeg = m_frame.rotX;
+        packet.rotYdeg = m_frame.rotY;
+        packet.rotZdeg = m_frame.rotZ;
+        if (alpha <= 0.0f || !m_hasNext || m_next.index != m_frame.index + 1 || !engineRunning()) {
+            return;
         }
+        auto lerp = [alpha](float a, float b) { return a + alpha * (b - a); };
+        // Shortest way around for angles in degrees
+        auto lerpAngle = [alpha](float a, float b) {
+            return a + alpha * (b - a - 360.0f * std::round((b - a) / 360.0f));
+        };
+        packet.posX = lerp(m_frame.posX, m_next.posX);
+        packet.posY = lerp(m_frame.posY, m_next.posY);
+        packet.posZ = lerp(m_frame.posZ, m_next.posZ);
+        packet.rotXdeg = lerpAngle(m_frame.rotX, m_next.rotX);
+        packet.rotYdeg = lerpAngle(m_frame.rotY, m_next.rotY);
+        packet.rotZdeg = lerpAngle(m_frame.rotZ, m_next.rotZ);
     }
 
-    static std::default_random_engine rng(std::random_device{}());
-    std::normal_distribution<float> dist(0.0f, 0.5f);
+    void setButtonStates(uint8_t states)
+    {
+        uint8_t oldState = m_buttonStates;
+        m_buttonStates = states;
 
-    // Open the data file
-    std::ifstream fin(profile.dataFile);
-    if (!fin.is_open()) {
-        std::cerr << "Error: cannot open data file: " << profile.dataFile << "\n";
-        return 1;
+        // Log state changes for debugging
+        bool wasRunning = (oldState & 0x01) != 0;
+        bool nowRunning = (m_buttonStates & 0x01) != 0;
+        if (wasRunning != nowRunning) {
+            std::cout << "Rover " << m_id << " engine "
+                      << (nowRunning ? "STARTED" : "STOPPED") << "\n";
+        }
     }
 
-    // Create UDP sockets for sending pose & LiDAR
-    int udpSockPose  = createUDPSocket();
-    int udpSockLidar = createUDPSocket();
-    int udpSockTelem = createUDPSocket();
+    void pollCommands()
+    {
+        // Drain pending commands on cmdSock (non-blocking)
+        char cmd[128];
+        ssize_t n;
+        while ((n = recv(m_cmdSock, cmd, sizeof(cmd) - 1, MSG_DONTWAIT)) > 0) {
+            if (n == 1) {
+                setButtonStates(static_cast<uint8_t>(cmd[0]));
+            } else {
+                cmd[n] = '\0';
+                handleTextCommand(cmd);
+            }
+        }
+    }
 
-    // Listen for button commands
-    int cmdSock = createUDPSocket();
+    void handleTextCommand(const char* text)
+    {
+        char verb[16] = {};
+        char arg1[32] = {};
+        char arg2[32] = {};
+        int fields = std::sscanf(text, "%15s %31s %31s", verb, arg1, arg2);
+        std::string command = verb;
+        uint32_t frames = m_pipeline->frameCount();
 
-    // Bind cmdSock to cmdPort on localhost
-    int cmdPort = profile.cmdPort;
+        if (command == "seek" && fields >= 2) {
+            uint32_t frame = parseFramePosition(arg1);
+            if (frame < frames) {
+                m_pipeline->seek(frame);
+                discardNext();
+                std::cout << "Rover " << m_id << " seek to frame " << frame << "\n";
+                return;
+            }
+        } else if (command == "loop" && fields >= 2) {
+            bool loop = (std::string(arg1) == "on");
+            m_pipeline->setLoop(loop);
+            std::cout << "Rover " << m_id << " loop " << (loop ? "on" : "off") << "\n";
+            return;
+        } else if (command == "range" && fields == 2 && std::string(arg1) == "off") {
+            m_pipeline->clearRange();
+            std::cout << "Rover " << m_id << " range cleared\n";
+            return;
+        } else if (command == "range" && fields >= 3) {
+            uint32_t first = parseFramePosition(arg1);
+            uint32_t last = std::min(parseFramePosition(arg2), frames);
+            if (first < last) {
+                m_pipeline->setRange(first, last);
+                discardNext();
+                std::cout << "Rover " << m_id << " replaying frames " << first << "-" << last << "\n";
+                return;
+            }
+        }
+        std::cerr << "Rover " << m_id << ": ignoring command '" << text << "' ("
+                  << frames << " frames)\n";
+    }
+
+    // "1234" is a frame number, "300s" / "12.5s" a time offset at 10 Hz
+    static uint32_t parseFramePosition(const char* text)
     {
-        sockaddr_in cmdAddr;
-        std::memset(&cmdAddr, 0, sizeof(cmdAddr));
-        cmdAddr.sin_family = AF_INET;
-        cmdAddr.sin_port   = htons(cmdPort);
-        cmdAddr.sin_addr.s_addr = inet_addr(LOOPBACK_ADDR);
+        char* end = nullptr;
+        double value = std::strtod(text, &end);
+        if (end == text) {
+            return UINT32_MAX;
+        }
+        if (*end == 's') {
+            value *= 10.0;
+        }
+        // Written so NaN fails too; anything out of range is no frame
+        if (!(value >= 0.0) || !(value < static_cast<double>(UINT32_MAX))) {
+            return UINT32_MAX;
+        }
+        return static_cast<uint32_t>(value);
+    }
 
-        if (bind(cmdSock, reinterpret_cast<sockaddr*>(&cmdAddr), sizeof(cmdAddr)) < 0) {
-            std::cerr << "Error: cannot bind command socket on port " << cmdPort << "\n";
-            return 1;
+    // Noise injection plus the clone offset, applied to a fresh frame.
+    // Runs on the pipeline's producer side, which owns m_noise. The
+    // noise is a function of (seed, rover, frame index) only, so a run
+    // repeats exactly with the same --seed whatever the timing.
+    void perturbFrame(Frame& frame)
+    {
+        bool shifted = (m_profile.offsetX != 0.0f || m_profile.offsetZ != 0.0f);
+        if (m_options.noNoise && !shifted) {
+            return;
+        }
+
+        frame.posX += m_profile.offsetX;
+        frame.posZ += m_profile.offsetZ;
+        LidarPoint* cloud = frame.makeWritable();
+        for (size_t i = 0; i < frame.numPoints; ++i) {
+            cloud[i].x += m_profile.offsetX;
+            cloud[i].z += m_profile.offsetZ;
+        }
+
+        // Inject noise if !noNoise:
+        if (!m_options.noNoise) {
+            uint64_t mix = m_options.seed ^ (static_cast<uint64_t>(m_id) << 32) ^ frame.index;
+            m_noise.reseed(NoiseGenerator::splitMix64(mix));
+
+            float pose[6] = { frame.posX, frame.posY, frame.posZ, frame.rotX, frame.rotY, frame.rotZ };
+            m_noise.addNormal(pose, 6, NOISE_SIGMA);
+            frame.posX = pose[0]; frame.posY = pose[1]; frame.posZ = pose[2];
+            frame.rotX = pose[3]; frame.rotY = pose[4]; frame.rotZ = pose[5];
+
+            // Points are packed x,y,z floats: perturb them as one flat array
+            static_assert(sizeof(LidarPoint) == 3 * sizeof(float), "LidarPoint must be 3 packed floats");
+            m_noise.addNormal(reinterpret_cast<float*>(cloud), frame.numPoints * 3, NOISE_SIGMA);
+        }
+    }
+
+    // --delta: drops the points whose voxel was sent recently. Runs at
+    // send time, on frames whose scan actually goes out: with --lidar-hz
+    // below 10 (or a seek) a frame may be replaced before its LiDAR tick,
+    // and marking its voxels sent would leave holes at the receiver.
+    void filterFrame(Frame& frame)
+    {
+        frame.suppressed = 0;
+        if (!m_delta) {
+            return;
         }
+        LidarPoint* cloud = frame.makeWritable();
+        size_t kept = m_delta->filter(cloud, frame.numPoints, frame.index, cloud);
+        frame.suppressed = static_cast<uint32_t>(frame.numPoints - kept);
+        frame.numPoints = kept;
     }
 
+    void sendPose(double timestamp, float frameAlpha, SendStats& stats)
+    {
+        PosePacket posePacket;
+        posePacket.timestamp = timestamp;
+        fillPose(posePacket, frameAlpha);
+        posePacket.sequence = m_poseSequence++;
+        toWire(posePacket);
+
+        sendSingle(IMPAIR_POSE, m_poseSock, MUX_STREAM_POSE, &posePacket, sizeof(posePacket), stats);
+    }
+
+    // --state: pose and button states in one packet, on the pose stream
+    // (and its --impair settings)
+    void sendState(double timestamp, float frameAlpha, SendStats& stats)
+    {
+        StatePacket state;
+        std::memset(&state, 0, sizeof(state));
+        state.timestamp = timestamp;
+        if (m_hasData) {
+            fillPose(state, frameAlpha);
+            state.flags = STATE_FLAG_POSE;
+        }
+        state.buttonStates = m_buttonStates;
+        state.sequence = m_stateSequence++;
+        toWire(state);
+
+        sendSingle(IMPAIR_POSE, m_poseSock, MUX_STREAM_STATE, &state, sizeof(state), stats);
+    }
+
+    // Writes one message to the shared-memory ring, if a reader is
+    // attached. Returns false if the caller should use UDP instead.
+    static_assert(SHM_STREAM_POSE == MUX_STREAM_POSE && SHM_STREAM_LIDAR == MUX_STREAM_LIDAR &&
+                  SHM_STREAM_TELEM == MUX_STREAM_TELEM && SHM_STREAM_STATE == MUX_STREAM_STATE,
+                  "ring records and mux headers use the same stream types");
+    bool writeShm(uint8_t type, const void* head, size_t headSize, const void* body, size_t bodySize,
+                  SendStats& stats)
+    {
+        if (!m_ringActive) {
+            return false;
+        }
+        if (m_ring->write(type, head, headSize, body, bodySize)) {
+            stats.shmRecords++;
+            stats.bytes += headSize + bodySize;
+        } else {
+            stats.shmFull++;
+        }
+        return true;
+    }
+
+    // Sends one packet (already in wire order) of the given MUX_STREAM_*
+    // type, through the impairment link of 'stream' if it has one. With
+    // --mux a MuxHeader goes in front.
+    void sendSingle(int stream, int sock, uint8_t type, const void* data, size_t size, SendStats& stats)
+    {
+        if (writeShm(type, data, size, nullptr, 0, stats)) {
+            return;
+        }
+        const void* head = data;
+        size_t headSize = size;
+        const void* body = nullptr;
+        size_t bodySize = 0;
+        MuxHeader mux = m_muxHeader;
+        mux.stream = type;
+        toWire(mux);
+        if (m_options.multiplexed) {
+            head = &mux;
+            headSize = sizeof(MuxHeader);
+            body = data;
+            bodySize = size;
+        }
+        if (m_links[stream]) {
+            m_links[stream]->add(head, headSize, body, bodySize);
+            m_links[stream]->flush(sock, stats);
+        } else {
+            sendDatagram(sock, head, headSize, body, bodySize, stats);
+        }
+    }
+
+    // Splits the frame into chunks that each fit one datagram of
+    // m_lidarDatagramBytes, then sends them in one sendmmsg. On loopback
+    // that is usually the whole scan in a single datagram.
+    // With --delta, the frame only holds the points the voxel filter let
+    // through, and every chunk is flagged as part of a delta scan.
+    // With --quantize, chunks carry int16 points (twice as many per
+    // datagram); a chunk too spread out for int16 is resent as floats,
+    // split to fit.
+    // With --pace, only the first burst goes out here; paceLidar() sends
+    // the rest over the tick.
+    static_assert(terrafirma::HOST_IS_LITTLE_ENDIAN,
+                  "point arrays are sent as they lie in memory; a big-endian host needs a swap pass");
+    void sendLidar(double timestamp, SendStats& stats)
+    {
+        bool quantize = m_options.quantizeResolution > 0.0f;
+        // Through shared memory a scan is a single record; with --mux
+        // each datagram also carries a MuxHeader
+        bool muxed = m_options.multiplexed && !m_ringActive;
+        size_t limit = m_ringActive ? m_ring->maxPayload() : m_lidarDatagramBytes;
+        size_t overhead = sizeof(LidarPacketHeader) + (muxed ? sizeof(MuxHeader) : 0);
+        size_t payload = limit > overhead ? limit - overhead : 0;
+        size_t floatPoints = payload / sizeof(LidarPoint);
+        size_t q16Points = payload / sizeof(LidarPointQ16);
+
+        // Chunks (and quantized points) live here until the flush;
+        // float points are sent from the frame
+        m_chunks.clear();
+        m_unsentChunk = 0;
+        // Not even one float point fits: every chunk would be empty.
+        // main() rejects such a --chunk-bytes, so only a path MTU this
+        // small gets here
+        if (floatPoints == 0) {
+            if (!m_lidarTooSmallReported) {
+                std::cerr << "Rover " << m_id << ": LiDAR datagram limit of " << limit
+                          << " bytes can't hold a point, not sending LiDAR\n";
+                m_lidarTooSmallReported = true;
+            }
+            return;
+        }
+
+        const LidarPoint* points = m_frame.points;
+        size_t totalPoints = m_frame.numPoints;
+        uint16_t flags = m_delta ? LIDAR_FLAG_DELTA : 0;
+        stats.lidarPoints += totalPoints + m_frame.suppressed;
+        stats.lidarSuppressed += m_frame.suppressed;
+        if (quantize) {
+            m_quantized.resize(totalPoints);
+        }
+
+        size_t startIdx = 0;
+        do {
+            size_t numPts = std::min(quantize ? q16Points : floatPoints, totalPoints - startIdx);
+            LidarChunk& chunk = addChunk(timestamp, points, startIdx, numPts);
+            if (quantize) {
+                if (quantizeChunk(points + startIdx, numPts, m_options.quantizeResolution,
+                                  chunk.header, m_quantized.data() + startIdx)) {
+                    chunk.body = m_quantized.data() + startIdx;
+                    chunk.bodySize = numPts * sizeof(LidarPointQ16);
+                } else {
+                    // Float points take twice the room: split the range again
+                    m_chunks.pop_back();
+                    for (size_t i = 0; i < numPts; i += floatPoints) {
+                        addChunk(timestamp, points, startIdx + i, std::min(floatPoints, numPts - i));
+                    }
+                }
+            }
+            startIdx += numPts;
+        } while (startIdx < totalPoints);
+
+        uint32_t scanId = m_scanId++;
+        size_t scanBytes = 0;
+        for (LidarChunk& chunk : m_chunks) {
+            chunk.header.scanId = scanId;
+            chunk.header.sequence = m_lidarSequence++;
+            chunk.header.totalChunks = static_cast<uint32_t>(m_chunks.size());
+            chunk.header.flags = flags;
+            chunk.header.suppressedPoints = m_frame.suppressed;
+            chunk.header.scanPoints = static_cast<uint32_t>(totalPoints);
+            toWire(chunk.header);
+            if (writeShm(SHM_STREAM_LIDAR, &chunk.header, sizeof(LidarPacketHeader), chunk.body, chunk.bodySize,
+                         stats)) {
+                continue;
+            }
+            scanBytes += chunkBytes(chunk);
+        }
+
+        m_unsentChunk = m_ringActive ? m_chunks.size() : 0;
+        if (m_ringActive) {
+            return;
+        } else if (m_pacer) {
+            m_pacer->start(scanBytes, std::chrono::steady_clock::now(), m_paceWindow);
+            paceLidar(std::chrono::steady_clock::now(), stats);
+            return;
+        }
+        while (m_unsentChunk < m_chunks.size()) {
+            queueChunk(m_chunks[m_unsentChunk++]);
+        }
+        flushLidar(stats);
+    }
+
+    struct LidarChunk {
+        MuxHeader mux;  // sent in front of the header with --mux
+        LidarPacketHeader header;
+        const void* body;
+        size_t bodySize;
+    };
+    static_assert(offsetof(LidarChunk, header) == sizeof(MuxHeader), "mux and LiDAR headers must be contiguous");
+
+    // Datagram size of a chunk sent over UDP
+    size_t chunkBytes(const LidarChunk& chunk) const
+    {
+        return sizeof(LidarPacketHeader) + (m_options.multiplexed ? sizeof(MuxHeader) : 0) + chunk.bodySize;
+    }
+
+    // Queues a chunk for UDP on the LiDAR link (impaired or not);
+    // flushLidar() sends what is queued
+    void queueChunk(const LidarChunk& chunk)
+    {
+        // The mux header sits right before the LiDAR header
+        const void* head = m_options.multiplexed ? static_cast<const void*>(&chunk.mux) : &chunk.header;
+        size_t headSize = chunkBytes(chunk) - chunk.bodySize;
+        if (m_links[IMPAIR_LIDAR]) {
+            m_links[IMPAIR_LIDAR]->add(head, headSize, chunk.body, chunk.bodySize);
+        } else {
+            m_lidarBatch.add(head, headSize, chunk.body, chunk.bodySize);
+        }
+    }
+
+    void flushLidar(SendStats& stats)
+    {
+        if (m_links[IMPAIR_LIDAR]) {
+            m_links[IMPAIR_LIDAR]->flush(m_lidarSock, stats);
+        } else {
+            m_lidarBatch.flush(m_lidarSock, stats);
+        }
+    }
+
+    // Appends a float32 chunk for points [startIdx, startIdx + numPts);
+    // totalChunks and scanPoints are filled in once the frame is fully split
+    LidarChunk& addChunk(double timestamp, const LidarPoint* points, size_t startIdx, size_t numPts)
+    {
+        m_chunks.emplace_back();
+        LidarChunk& chunk = m_chunks.back();
+        chunk.mux = m_muxHeader;
+        chunk.mux.stream = MUX_STREAM_LIDAR;
+        toWire(chunk.mux);
+        std::memset(&chunk.header, 0, sizeof(chunk.header));
+        chunk.header.magic = LIDAR_MAGIC;
+        chunk.header.version = LIDAR_PROTOCOL_VERSION;
+        chunk.header.encoding = LIDAR_ENCODING_FLOAT32;
+        chunk.header.timestamp = timestamp;
+        chunk.header.chunkIndex = static_cast<uint32_t>(m_chunks.size() - 1);
+        chunk.header.pointsInThisChunk = static_cast<uint32_t>(numPts);
+        chunk.header.firstPoint = static_cast<uint32_t>(startIdx);
+        chunk.body = points + startIdx;
+        chunk.bodySize = numPts * sizeof(LidarPoint);
+        return chunk;
+    }
+
+    int m_id;
+    RoverProfile m_profile;
+    const EmulatorOptions& m_options;
+
+    std::unique_ptr<FramePipeline> m_pipeline;
+    Frame m_frame;          // current frame data (preserved when paused)
+    bool m_hasData = false; // whether we have valid data to send
+    Frame m_next;           // the frame after m_frame, fetched ahead
+    bool m_hasNext = false;
+    bool m_ended = false;   // no frame after m_frame: data exhausted
+    bool m_lidarPending = false;  // m_frame's scan not sent yet
+
     // Button states - bit 0 controls engine (pause/resume)
     // Start with engine ON (bit 0 = 1)
-    uint8_t buttonStates = 0x01;
+    uint8_t m_buttonStates = 0x01;
+    int m_cmdSock = -1;
+
+    int m_poseSock = -1;
+    int m_lidarSock = -1;
+    int m_telemSock = -1;
+    MuxHeader m_muxHeader = {};  // with --mux; 'stream' is set per datagram
+    size_t m_lidarDatagramBytes = MAX_UDP_PAYLOAD;
+    bool m_lidarTooSmallReported = false;  // limit below one point, said once
+    std::vector<LidarChunk> m_chunks;
+    size_t m_unsentChunk = 0;   // m_chunks from here on still wait for the pacer
+    std::vector<LidarPointQ16> m_quantized;
+    DatagramBatch m_lidarBatch;
+    std::unique_ptr<ImpairedLink> m_links[IMPAIR_STREAM_COUNT];  // null = perfect link
+    std::unique_ptr<ShmRingWriter> m_ring;  // null = UDP only
+    bool m_ringActive = false;              // a reader is attached this tick
+    std::unique_ptr<TokenBucketPacer> m_pacer;  // --pace; null = whole scan at once
+    std::chrono::steady_clock::duration m_paceWindow{};
+
+    // Datagram counters per stream (before impairment, so drops show up
+    // as gaps at the receiver) and the LiDAR scan counter
+    uint32_t m_poseSequence = 0;
+    uint32_t m_lidarSequence = 0;
+    uint32_t m_telemSequence = 0;
+    uint32_t m_stateSequence = 0;
+    uint32_t m_scanId = 0;
 
-    const double freqHz = 10.0;
-    const std::chrono::milliseconds loopDelayMs((int)(1000.0 / freqHz));
+    NoiseGenerator m_noise;  // producer side only
+    std::unique_ptr<VoxelDeltaFilter> m_delta;  // scans sent so far; null = full scans
+};
+
+void printUsage(const char* prog)
+{
+    std::cerr << "Usage: " << prog << " <ROVER_IDS> [options]\n"
+              << "       " << prog << " --fleet <N> [options]\n"
+              << "  ROVER_IDS        one ID, a range or a list, e.g. 2, 1-5, 1,3,10-20\n"
+              << "  --fleet N        emulate rovers 1..N in this process\n"
+              << "  --spacing M      meters between cloned fleets for IDs > 5 (default 500)\n"
+              << "  --no-noise       replay the data without noise\n"
+              << "  --binary         replay the converted .scan files\n"
+              << "  --loop           restart each rover at the end of its data\n"
+              << "  --rate X         replay speed multiplier (default 1), or 'max' for unthrottled\n"
+              << "  --seed N         noise seed, to repeat a run exactly (default: random)\n"
+              << "  --quantize M     send LiDAR points as int16 steps of M meters (e.g. 0.01)\n"
+              << "  --delta V        send only LiDAR points in V-meter voxels not sent recently\n"
+              << "  --delta-window S seconds of data a sent voxel stays suppressed (default 5)\n"
+              << "  --mux            send every stream to one port (" << INGEST_PORT << ") behind a\n"
+              << "                   rover/stream header; the visualization needs --mux too\n"
+              << "  --state          send pose and telemetry as one packet, at the pose rate\n"
+              << "  --shm            send through a shared-memory ring per rover while the\n"
+              << "                   visualization is attached (UDP otherwise)\n"
+              << "  --pose-hz F      pose packets per second, interpolated between the 10 Hz\n"
+              << "                   logged frames (default 10)\n"
+              << "  --lidar-hz F     LiDAR scans per second, at most 10 (default 10)\n"
+              << "  --telem-hz F     telemetry packets per second (default 10)\n"
+              << "  --pace B         spread each LiDAR scan over the frame in bursts of at most\n"
+              << "                   B bytes instead of sending it at once\n"
+              << "  --chunk-bytes N  largest LiDAR datagram in bytes (default: path MTU, i.e.\n"
+              << "                   65507 on loopback; 1472 fits a 1500-byte Ethernet MTU)\n"
+              << "  --impair S:K=V,..  simulate a bad link on stream S (pose, lidar, telem, all);\n"
+              << "                   K is drop, burst, burstlen, dup, reorder, rate, bucket, queue\n"
+              << "                   e.g. --impair lidar:drop=0.02,reorder=16,rate=20m (repeatable)\n"
+              << "  --readahead N    frames decoded ahead per rover on a background thread\n"
+              << "                   (default 4, 0 = decode inline in the send loop)\n"
+              << "  --stats          print send and tick statistics every few seconds\n";
+}
+
+// --------------------------------------------------------------------
+// One line of send statistics for the interval just finished.
+// --------------------------------------------------------------------
+void printSendStats(SendStats& stats, double seconds)
+{
+    double frames = stats.frames > 0 ? static_cast<double>(stats.frames) : 1.0;
+    double syscalls = stats.syscalls > 0 ? static_cast<double>(stats.syscalls) : 1.0;
+
+    std::cout << std::fixed << std::setprecision(1)
+              << "[stats] " << (stats.frames / seconds) << " frames/s"
+              << " | " << (stats.bytes / seconds / (1024.0 * 1024.0)) << " MB/s"
+              << " | " << (stats.syscalls / frames) << " syscalls/frame"
+              << " | " << (stats.datagrams / syscalls) << " datagrams/syscall"
+              << " | " << (stats.sendMicros / frames) << " us/frame";
+    if (!stats.poseDelay.empty()) {
+        std::cout << " | pose delay p50 " << stats.poseDelay.percentile(0.5) << " us"
+                  << ", p99 " << stats.poseDelay.percentile(0.99) << " us"
+                  << ", max " << stats.poseDelay.percentile(1.0) << " us";
+    }
+    if (stats.shmRecords + stats.shmFull > 0) {
+        std::cout << " | shm: " << stats.shmRecords << " records";
+        if (stats.shmFull > 0) {
+            std::cout << ", " << stats.shmFull << " dropped (ring full)";
+        }
+    }
+    if (stats.pacedBursts > 0) {
+        std::cout << " | paced: " << (stats.pacedBursts / frames) << " bursts/frame";
+        if (stats.pacedLate > 0) {
+            std::cout << ", " << stats.pacedLate << " chunks late";
+        }
+    }
+    if (stats.lidarSuppressed > 0) {
+        std::cout << " | delta: " << (100.0 * stats.lidarSuppressed / stats.lidarPoints)
+                  << "% of points suppressed";
+    }
+    if (stats.underruns > 0) {
+        std::cout << " | " << stats.underruns << " decode underruns";
+    }
+    if (stats.impairDropped + stats.impairDuplicated + stats.impairReordered + stats.impairOverflow > 0) {
+        std::cout << " | impaired: " << stats.impairDropped << " dropped, "
+                  << stats.impairDuplicated << " duplicated, "
+                  << stats.impairReordered << " reordered, "
+                  << stats.impairOverflow << " over rate";
+    }
+    if (stats.refused > 0) {
+        std::cout << " | " << stats.refused << " refused (no receiver)";
+    }
+    if (stats.errors > 0) {
+        std::cout << " | " << stats.errors << " send errors";
+    }
+    std::cout << "\n";
+}
+
+// --------------------------------------------------------------------
+// One line of replay clock statistics for the interval just finished.
+// --------------------------------------------------------------------
+void printTickStats(TickStats& ticks, double seconds, bool throttled)
+{
+    std::cout << std::fixed << std::setprecision(1)
+              << "[clock] " << (ticks.ticks / seconds) << " ticks/s";
+    if (throttled) {
+        std::cout << " | lateness mean " << ticks.lateness.mean() << " us"
+                  << ", p99 " << ticks.lateness.percentile(0.99) << " us"
+                  << ", max " << ticks.lateness.percentile(1.0) << " us"
+                  << " | " << ticks.overruns << " overruns";
+    } else {
+        std::cout << " | unthrottled";
+    }
+    std::cout << "\n";
+}
+
+// Set by SIGINT/SIGTERM so the rovers are destroyed normally, which
+// removes their shared-memory rings
+static volatile std::sig_atomic_t g_stopRequested = 0;
+
+static void requestStop(int)
+{
+    g_stopRequested = 1;
+}
+
+int main(int argc, char** argv)
+{
+    EmulatorOptions options;
+    std::vector<int> roverIds;
+    bool seeded = false;
+    bool chunkBytesSet = false;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--no-noise") {
+            options.noNoise = true;
+        } else if (arg == "--binary") {
+            options.useBinary = true;
+        } else if (arg == "--loop") {
+            options.loop = true;
+        } else if (arg == "--stats") {
+            options.printStats = true;
+        } else if (arg == "--rate" && i + 1 < argc) {
+            std::string rate = argv[++i];
+            options.rate = (rate == "max") ? 0.0 : std::strtod(rate.c_str(), nullptr);
+            if (rate != "max" && !(options.rate > 0.0 && std::isfinite(options.rate))) {
+                std::cerr << "Error: --rate must be positive or 'max'\n";
+                return 1;
+            }
+        } else if (arg == "--seed" && i + 1 < argc) {
+            options.seed = std::strtoull(argv[++i], nullptr, 10);
+            seeded = true;
+        } else if (arg == "--quantize" && i + 1 < argc) {
+            options.quantizeResolution = std::strtof(argv[++i], nullptr);
+            if (!(options.quantizeResolution > 0.0f)) {
+                std::cerr << "Error: --quantize needs a positive resolution in meters\n";
+                return 1;
+            }
+        } else if (arg == "--shm") {
+            options.sharedMemory = true;
+        } else if (arg == "--mux") {
+            options.multiplexed = true;
+        } else if (arg == "--state") {
+            options.statePackets = true;
+        } else if (arg == "--delta" && i + 1 < argc) {
+            options.deltaVoxel = std::strtof(argv[++i], nullptr);
+            if (!(options.deltaVoxel > 0.0f)) {
+                std::cerr << "Error: --delta needs a positive voxel size in meters\n";
+                return 1;
+            }
+        } else if (arg == "--delta-window" && i + 1 < argc) {
+            options.deltaWindow = std::strtod(argv[++i], nullptr);
+            if (!(options.deltaWindow > 0.0)) {
+                std::cerr << "Error: --delta-window must be positive\n";
+                return 1;
+            }
+        } else if ((arg == "--pose-hz" || arg == "--lidar-hz" || arg == "--telem-hz") && i + 1 < argc) {
+            double hz = std::strtod(argv[++i], nullptr);
+            if (!(hz > 0.0) || hz > 1000.0) {
+                std::cerr << "Error: " << arg << " must be between 0 and 1000\n";
+                return 1;
+            }
+            if (arg == "--lidar-hz" && hz > DATA_FRAME_HZ) {
+                std::cerr << "Error: --lidar-hz can't exceed the " << DATA_FRAME_HZ
+                          << " Hz the scans were logged at\n";
+                return 1;
+            }
+            double& rate = arg == "--pose-hz" ? options.poseHz
+                         : arg == "--lidar-hz" ? options.lidarHz : options.telemHz;
+            rate = hz;
+        } else if (arg == "--pace" && i + 1 < argc) {
+            options.paceBurstBytes = static_cast<size_t>(std::strtoul(argv[++i], nullptr, 10));
+            if (options.paceBurstBytes == 0) {
+                std::cerr << "Error: --pace needs a burst size in bytes (e.g. 16384)\n";
+                return 1;
+            }
+        } else if (arg == "--chunk-bytes" && i + 1 < argc) {
+            // Checked below, once --mux is known
+            options.chunkBytes = static_cast<size_t>(std::strtoul(argv[++i], nullptr, 10));
+            chunkBytesSet = true;
+        } else if (arg == "--impair" && i + 1 < argc) {
+            if (!parseImpairment(argv[++i], options.impair)) {
+                return 1;
+            }
+        } else if (arg == "--readahead" && i + 1 < argc) {
+            options.readahead = static_cast<size_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--fleet" && i + 1 < argc) {
+            if (!parseRoverIds("1-" + std::string(argv[++i]), roverIds)) {
+                return 1;
+            }
+        } else if (arg == "--spacing" && i + 1 < argc) {
+            options.cloneSpacing = std::strtof(argv[++i], nullptr);
+        } else if (arg.rfind("--", 0) != 0) {
+            if (!parseRoverIds(arg, roverIds)) {
+                return 1;
+            }
+        } else {
+            std::cerr << "Error: unknown option: " << arg << "\n";
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (roverIds.empty()) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    // A LiDAR datagram must hold its headers and at least one float point
+    if (chunkBytesSet) {
+        size_t minimum = sizeof(LidarPacketHeader) + sizeof(LidarPoint) +
+                         (options.multiplexed ? sizeof(MuxHeader) : 0);
+        if (options.chunkBytes < minimum || options.chunkBytes > MAX_UDP_PAYLOAD) {
+            std::cerr << "Error: --chunk-bytes must be between " << minimum
+                      << " and " << MAX_UDP_PAYLOAD << (options.multiplexed ? " with --mux" : "") << "\n";
+            return 1;
+        }
+    }
+
+    if (!seeded) {
+        std::random_device rd;
+        options.seed = (static_cast<uint64_t>(rd()) << 32) | rd();
+    }
+
+    // Four sockets per rover (two with --mux), plus stdio and data files
+    rlim_t perRover = options.multiplexed ? 4 : 6;
+    if (!ensureFileLimit(static_cast<rlim_t>(roverIds.size()) * perRover + 64)) {
+        std::cerr << "Warning: open-file limit may be too low for "
+                  << roverIds.size() << " rovers (see ulimit -n)\n";
+    }
+
+    StreamSchedule schedule(options);
+    // The clock counts whole nanoseconds per tick
+    if (options.rate > 0.0 && 1e9 / (schedule.tickHz() * options.rate) < 1.0) {
+        std::cerr << "Error: --rate " << options.rate << " gives ticks shorter than 1 ns at "
+                  << schedule.tickHz() << " Hz; use --rate max\n";
+        return 1;
+    }
+
+    // Build every rover up front; any bad data file or busy port aborts
+    std::vector<std::unique_ptr<RoverSim>> rovers;
+    rovers.reserve(roverIds.size());
+    for (int id : roverIds) {
+        auto rover = std::make_unique<RoverSim>(id, makeRoverProfile(id, options.cloneSpacing), options);
+        if (!rover->init()) {
+            return 1;
+        }
+        rovers.push_back(std::move(rover));
+    }
+
+    // One decode thread keeps every rover's read-ahead queue filled
+    std::unique_ptr<DecodeWorker> decoder;
+    if (options.readahead > 0) {
+        decoder = std::make_unique<DecodeWorker>();
+        for (auto& rover : rovers) {
+            decoder->add(&rover->pipeline());
+        }
+        // Let the first frames decode so the first tick doesn't underrun
+        for (auto& rover : rovers) {
+            while (!rover->pipeline().ready()) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+    }
+
+    ReplayClock clock(1.0 / schedule.tickHz(), options.rate, options.printStats);
 
     auto startTime = std::chrono::steady_clock::now();
 
-    // Current line data (preserved when paused)
-    std::string line;
-    float posX=0, posY=0, posZ=0;
-    float rotX=0, rotY=0, rotZ=0;
-    std::vector<LidarPoint> cloud;
-    bool hasData = false;  // Whether we have valid data to send
-    
-    std::cout << "Rover " << roverID << " emulator started (engine ON by default)\n";
-
-    // Main loop
-    while (true) {
-        // Check for incoming button command on cmdSock (non-blocking)
-        uint8_t cmdByte = 0;
-        ssize_t n = recv(cmdSock, &cmdByte, 1, MSG_DONTWAIT);
-        if (n == 1) {
-            uint8_t oldState = buttonStates;
-            buttonStates = cmdByte;
-            
-            // Log state changes for debugging
-            bool wasRunning = (oldState & 0x01) != 0;
-            bool nowRunning = (buttonStates & 0x01) != 0;
-            if (wasRunning != nowRunning) {
-                std::cout << "Rover " << roverID << " engine " 
-                          << (nowRunning ? "STARTED" : "STOPPED") << "\n";
-            }
-        }
-
-        // Check if engine is running (bit 0)
-        bool engineRunning = (buttonStates & 0x01) != 0;
+    SendStats stats;
+    const std::chrono::seconds statsInterval(5);
+    auto statsStart = startTime;
+
+    if (rovers.size() == 1) {
+        std::cout << "Rover " << rovers[0]->id() << " emulator started (engine ON by default)\n";
+    } else {
+        std::cout << "Fleet emulator started: " << rovers.size()
+                  << " rovers (engine ON by default)\n";
+    }
+    bool impaired = false;
+    for (const ImpairmentConfig& config : options.impair) {
+        impaired = impaired || config.enabled();
+    }
+    if (!options.noNoise || impaired) {
+        std::cout << "Seed " << options.seed << " (repeat with --seed)\n";
+    }
+    std::cout << "LiDAR datagrams up to " << rovers[0]->lidarDatagramBytes() << " bytes"
+              << (options.chunkBytes ? "" : " (path MTU)") << "\n";
+    if (options.multiplexed) {
+        std::cout << "Multiplexed: all streams to port " << INGEST_PORT << "\n";
+    }
+    if (options.sharedMemory) {
+        std::cout << "Shared memory enabled; streams switch from UDP once the visualization attaches\n";
+        if (impaired) {
+            std::cout << "Note: --impair only applies to streams sent over UDP\n";
+        }
+    }
+    bool pacing = options.paceBurstBytes > 0 && clock.throttled();
+    if (pacing) {
+        std::cout << "LiDAR paced over " << PACE_FRAME_FRACTION * 100.0 << "% of each frame, bursts up to "
+                  << options.paceBurstBytes << " bytes\n";
+    } else if (options.paceBurstBytes > 0) {
+        std::cout << "Note: --pace has no effect with --rate max\n";
+    }
+    if (schedule.tickHz() != DATA_FRAME_HZ || options.lidarHz != DATA_FRAME_HZ ||
+        options.telemHz != DATA_FRAME_HZ) {
+        std::cout << "Streams: pose " << options.poseHz << " Hz" << (options.statePackets ? " (state)" : "")
+                  << ", LiDAR " << options.lidarHz << " Hz, telemetry "
+                  << (options.statePackets ? options.poseHz : options.telemHz) << " Hz; "
+                  << schedule.tickHz() << " Hz ticks\n";
+    }
+    if (options.rate != 1.0) {
+        if (clock.throttled()) {
+            std::cout << "Replay rate " << options.rate << "x (" << schedule.tickHz() * options.rate << " Hz)\n";
+        } else {
+            std::cout << "Replay rate unthrottled\n";
+        }
+    }
+
+    std::signal(SIGINT, requestStop);
+    std::signal(SIGTERM, requestStop);
+    clock.start();
 
+    // Main loop: one pass over the fleet per replay tick
+    while (!rovers.empty() && !g_stopRequested) {
         // Create a timestamp (seconds since start)
         auto now = std::chrono::steady_clock::now();
         std::chrono::duration<double> elapsed = now - startTime;
         double timestamp = elapsed.count();
+        TickPlan plan = schedule.next();
 
-        // Only read new data if engine is running
-        if (engineRunning) {
-            // Try to read next line
-            if (std::getline(fin, line)) {
-                if (!line.empty()) {
-                    if (parseLine(line, posX, posY, posZ, rotX, rotY, rotZ, cloud)) {
-                        hasData = true;
-                        
-                        // Inject noise if !noNoise:
-                        if (!noNoise) {
-                            posX += dist(rng);
-                            posY += dist(rng);
-                            posZ += dist(rng);
-                            rotX += dist(rng);
-                            rotY += dist(rng);
-                            rotZ += dist(rng);
-                            for (auto& p : cloud) {
-                                p.x += dist(rng);
-                                p.y += dist(rng);
-                                p.z += dist(rng);
-                            }
-                        }
-                    }
-                }
+        for (auto it = rovers.begin(); it != rovers.end(); ) {
+            if ((*it)->step(plan, timestamp, now, stats)) {
+                ++it;
             } else {
-                // End of file - stop the emulator
-                break;
-            }
-        }
-        // When engine is stopped, we don't read new lines - data stays at last position
-
-        // Send pose data if we have it (even when paused, send last known position)
-        if (hasData) {
-            // 1) Build the PosePacket
-            PosePacket posePacket;
-            posePacket.timestamp = timestamp;
-            posePacket.posX = posX;
-            posePacket.posY = posY;
-            posePacket.posZ = posZ;
-            posePacket.rotXdeg = rotX;
-            posePacket.rotYdeg = rotY;
-            posePacket.rotZdeg = rotZ;
-
-            // 2) Send the pose over the pose port
-            sendUDP(udpSockPose, &posePacket, sizeof(posePacket), profile.posePort);
-
-            // 3) Only send LiDAR when engine is running (don't accumulate points when paused)
-            if (engineRunning) {
-                size_t totalPoints = cloud.size();
-                size_t totalChunks = (totalPoints + MAX_LIDAR_POINTS_PER_PACKET - 1) / MAX_LIDAR_POINTS_PER_PACKET;
-                if (totalChunks == 0) totalChunks = 1;
-
-                // For each chunk, build a LidarPacket
-                for (size_t chunkIndex = 0; chunkIndex < totalChunks; ++chunkIndex) {
-                    LidarPacket packet;
-                    std::memset(&packet, 0, sizeof(packet));
-
-                    packet.header.timestamp = timestamp;
-                    packet.header.chunkIndex = static_cast<uint32_t>(chunkIndex);
-                    packet.header.totalChunks = static_cast<uint32_t>(totalChunks);
-
-                    // Fill points in this chunk
-                    size_t startIdx = chunkIndex * MAX_LIDAR_POINTS_PER_PACKET;
-                    size_t endIdx = std::min(startIdx + MAX_LIDAR_POINTS_PER_PACKET, totalPoints);
-                    size_t numPts = endIdx - startIdx;
-                    packet.header.pointsInThisChunk = static_cast<uint32_t>(numPts);
-
-                    for (size_t i = 0; i < numPts; ++i) {
-                        packet.points[i] = cloud[startIdx + i];
-                    }
-
-                    // Send the packet over the LiDAR port
-                    size_t packetSize = sizeof(LidarPacketHeader) + (numPts * sizeof(LidarPoint));
-                    sendUDP(udpSockLidar, &packet, packetSize, profile.lidarPort);
+                std::cout << "Finished streaming rover " << (*it)->id() << " data.\n";
+                if (decoder) {
+                    decoder->remove(&(*it)->pipeline());
                 }
+                it = rovers.erase(it);
             }
         }
 
-        // Always send telemetry (so visualization knows button state)
-        VehicleTelem telem;
-        telem.timestamp    = timestamp;
-        telem.buttonStates = buttonStates;
+        // Stats cover one interval, printed or not, so they stay bounded
+        if (now - statsStart >= statsInterval) {
+            if (options.printStats) {
+                double seconds = std::chrono::duration<double>(now - statsStart).count();
+                printSendStats(stats, seconds);
+                printTickStats(clock.stats(), seconds, clock.throttled());
+            }
+            stats.reset();
+            clock.stats().reset();
+            statsStart = now;
+        }
 
-        int telemPort = profile.telemPort;
-        sendUDP(udpSockTelem, &telem, sizeof(telem), telemPort);
+        // With --pace, release LiDAR chunks as the rovers' token buckets
+        // allow until the next tick is due
+        if (pacing) {
+            auto tickDue = clock.nextTickTime();
+            while (!g_stopRequested) {
+                auto paceNow = std::chrono::steady_clock::now();
+                auto wake = std::chrono::steady_clock::time_point::max();
+                for (auto& rover : rovers) {
+                    wake = std::min(wake, rover->paceLidar(paceNow, stats));
+                }
+                if (wake >= tickDue) {
+                    break;
+                }
+                std::this_thread::sleep_until(wake);
+            }
+        }
 
-        // Sleep the remainder of the 10 Hz cycle
-        std::this_thread::sleep_for(loopDelayMs);
+        // Sleep until the next tick deadline
+        clock.waitNextTick();
     }
 
-    // Clean up
-    close(udpSockPose);
-    close(udpSockLidar);
-    close(udpSockTelem);
-    close(cmdSock);
-    fin.close();
+    // Report whatever the last partial interval collected
+    if (options.printStats && stats.frames > 0) {
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - statsStart).count();
+        printSendStats(stats, seconds);
+        printTickStats(clock.stats(), seconds, clock.throttled());
+    }
 
-    std::cout << "Finished streaming rover " << roverID << " data.\n";
     return 0;
 }
@@ -0,0 +1,46 @@
+#ifndef ROVER_PACKETS_H
+#define ROVER_PACKETS_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "rover_protocol.h"
+
+// --------------------------------------------------------------------
+// Packet structures and wire constants. They are defined once, for the
+// emulator and the visualization alike, in protocol/rover_protocol.h;
+// this header only brings them into the emulator's (global) namespace.
+//
+// Structs are filled in host order and passed through toWire() right
+// before they are sent.
+// --------------------------------------------------------------------
+using terrafirma::POSE_PORT_BASE;
+using terrafirma::LIDAR_PORT_BASE;
+using terrafirma::TELEM_PORT_BASE;
+using terrafirma::CMD_PORT_BASE;
+using terrafirma::INGEST_PORT;
+
+using terrafirma::PosePacket;
+using terrafirma::LidarPacketHeader;
+using terrafirma::LidarPoint;
+using terrafirma::LidarPointQ16;
+using terrafirma::VehicleTelem;
+using terrafirma::StatePacket;
+using terrafirma::MuxHeader;
+using terrafirma::LidarPacketHeaderView;
+using terrafirma::toWire;
+
+using terrafirma::LIDAR_MAGIC;
+using terrafirma::LIDAR_PROTOCOL_VERSION;
+using terrafirma::LIDAR_ENCODING_FLOAT32;
+using terrafirma::LIDAR_ENCODING_INT16;
+using terrafirma::LIDAR_FLAG_DELTA;
+using terrafirma::STATE_FLAG_POSE;
+using terrafirma::MUX_MAGIC;
+using terrafirma::MUX_PROTOCOL_VERSION;
+using terrafirma::MUX_STREAM_POSE;
+using terrafirma::MUX_STREAM_LIDAR;
+using terrafirma::MUX_STREAM_TELEM;
+using terrafirma::MUX_STREAM_STATE;
+
+#endif // ROVER_PACKETS_H
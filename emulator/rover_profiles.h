@@ -1,6 +1,11 @@
 #ifndef ROVER_PROFILES_H
 #define ROVER_PROFILES_H
 
+#include <map>
+#include <string>
+
+#include "rover_packets.h"
+
 // --------------------------------------------------------------------
 // Rover's "profile" data:
 // - dataFile: path to the .dat file
@@ -8,6 +13,8 @@
 // - lidarPort: UDP port for LiDAR (point cloud) data
 // - telemPort: UDP port for telemetry sending
 // - cmdPort: UDP port for receiving button commands
+// - offsetX/offsetZ: horizontal shift applied to pose and points
+//   (non-zero only for cloned rovers, see makeRoverProfile)
 // --------------------------------------------------------------------
 struct RoverProfile {
     std::string dataFile;
@@ -15,6 +22,8 @@ struct RoverProfile {
     int lidarPort;
     int telemPort;
     int cmdPort;
+    float offsetX = 0.0f;
+    float offsetZ = 0.0f;
 };
 
 
@@ -27,4 +36,32 @@ static std::map<std::string, RoverProfile> g_roverProfiles = {
     { "5", { "data/rover5.dat", 9005, 10005, 11005, 8005} }
 };
 
-#endif // ROVER_PROFILES_H
\ No newline at end of file
+// --------------------------------------------------------------------
+// Generated profiles for fleets larger than the recorded data set.
+//
+// Rover N uses port base + N on every stream (the same scheme as the
+// five fixed profiles), so IDs are capped below 1000 to keep each
+// stream's range clear of the next base. Rovers above 5 replay
+// dataset ((N-1) % 5) + 1, shifted on a grid of 'spacing' meters so
+// clones don't overlap.
+// --------------------------------------------------------------------
+static const int NUM_DATASETS  = 5;
+static const int MAX_ROVER_ID  = 999;
+static const int CLONE_GRID_COLUMNS = 10;
+
+inline RoverProfile makeRoverProfile(int roverId, float spacing)
+{
+    int dataset = ((roverId - 1) % NUM_DATASETS) + 1;
+    int clone = (roverId - 1) / NUM_DATASETS;
+
+    RoverProfile profile = g_roverProfiles.at(std::to_string(dataset));
+    profile.posePort  = POSE_PORT_BASE + roverId;
+    profile.lidarPort = LIDAR_PORT_BASE + roverId;
+    profile.telemPort = TELEM_PORT_BASE + roverId;
+    profile.cmdPort   = CMD_PORT_BASE + roverId;
+    profile.offsetX = static_cast<float>(clone % CLONE_GRID_COLUMNS) * spacing;
+    profile.offsetZ = static_cast<float>(clone / CLONE_GRID_COLUMNS) * spacing;
+    return profile;
+}
+
+#endif // ROVER_PROFILES_H
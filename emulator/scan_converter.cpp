@@ -0,0 +1,136 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cstdlib>
+
+#include "rover_packets.h"
+#include "dat_parser.h"
+#include "scan_format.h"
+
+// --------------------------------------------------------------------
+// Counts lines in a file without parsing them (upper bound on frames).
+// --------------------------------------------------------------------
+static uint64_t countLines(const std::string& path)
+{
+    std::ifstream fin(path, std::ios::binary);
+    std::vector<char> buffer(1 << 20);
+    uint64_t lines = 0;
+    bool pendingPartial = false;
+
+    while (fin) {
+        fin.read(buffer.data(), buffer.size());
+        std::streamsize got = fin.gcount();
+        for (std::streamsize i = 0; i < got; ++i) {
+            if (buffer[i] == '\n') {
+                ++lines;
+                pendingPartial = false;
+            } else {
+                pendingPartial = true;
+            }
+        }
+    }
+    return pendingPartial ? lines + 1 : lines;
+}
+
+// --------------------------------------------------------------------
+// Converts one rover .dat file into the binary .scan format.
+//
+// The index and pose sections are sized from a quick line count, the
+// points are streamed straight to disk while parsing, and the header,
+// index and poses are written last.
+// --------------------------------------------------------------------
+static bool convertFile(const std::string& inPath, const std::string& outPath)
+{
+    std::ifstream fin(inPath);
+    if (!fin.is_open()) {
+        std::cerr << "Error: cannot open data file: " << inPath << "\n";
+        return false;
+    }
+
+    std::ofstream fout(outPath, std::ios::binary | std::ios::trunc);
+    if (!fout.is_open()) {
+        std::cerr << "Error: cannot create scan file: " << outPath << "\n";
+        return false;
+    }
+
+    const uint64_t maxFrames = countLines(inPath);
+
+    ScanFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, SCAN_FILE_MAGIC, sizeof(SCAN_FILE_MAGIC));
+    header.version = SCAN_FILE_VERSION;
+    header.indexOffset = sizeof(ScanFileHeader);
+    header.posesOffset = header.indexOffset + maxFrames * sizeof(ScanFrameIndex);
+    header.pointsOffset = header.posesOffset + maxFrames * sizeof(ScanPose);
+
+    std::vector<ScanFrameIndex> index;
+    std::vector<ScanPose> poses;
+    index.reserve(maxFrames);
+    poses.reserve(maxFrames);
+
+    // Points go first, at their final offset
+    fout.seekp(static_cast<std::streamoff>(header.pointsOffset));
+
+    std::string line;
+    std::vector<LidarPoint> cloud;
+    uint64_t skipped = 0;
+    while (std::getline(fin, line)) {
+        ScanPose pose;
+        if (line.empty() ||
+            !parseLine(line, pose.posX, pose.posY, pose.posZ,
+                       pose.rotX, pose.rotY, pose.rotZ, cloud)) {
+            ++skipped;
+            continue;
+        }
+
+        ScanFrameIndex entry;
+        entry.firstPoint = header.pointCount;
+        entry.pointCount = static_cast<uint32_t>(cloud.size());
+        entry.reserved = 0;
+        index.push_back(entry);
+        poses.push_back(pose);
+
+        fout.write(reinterpret_cast<const char*>(cloud.data()),
+                   static_cast<std::streamsize>(cloud.size() * sizeof(LidarPoint)));
+        header.pointCount += cloud.size();
+    }
+    header.frameCount = static_cast<uint32_t>(index.size());
+
+    fout.seekp(0);
+    fout.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    fout.seekp(static_cast<std::streamoff>(header.indexOffset));
+    fout.write(reinterpret_cast<const char*>(index.data()),
+               static_cast<std::streamsize>(index.size() * sizeof(ScanFrameIndex)));
+    fout.seekp(static_cast<std::streamoff>(header.posesOffset));
+    fout.write(reinterpret_cast<const char*>(poses.data()),
+               static_cast<std::streamsize>(poses.size() * sizeof(ScanPose)));
+
+    if (!fout) {
+        std::cerr << "Error: failed writing scan file: " << outPath << "\n";
+        return false;
+    }
+
+    std::cout << inPath << " -> " << outPath << ": "
+              << header.frameCount << " frames, "
+              << header.pointCount << " points";
+    if (skipped > 0) {
+        std::cout << " (" << skipped << " lines skipped)";
+    }
+    std::cout << "\n";
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <input.dat> [output.scan]\n";
+        return 1;
+    }
+
+    std::string inPath = argv[1];
+    std::string outPath = (argc >= 3) ? argv[2] : scanFilePath(inPath);
+
+    return convertFile(inPath, outPath) ? 0 : 1;
+}
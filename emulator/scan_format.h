@@ -0,0 +1,175 @@
+#ifndef SCAN_FORMAT_H
+#define SCAN_FORMAT_H
+
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "rover_packets.h"
+
+// --------------------------------------------------------------------
+// Binary scan format (.scan), produced by scan_converter from a .dat.
+//
+// Layout (little-endian, host floats):
+//   ScanFileHeader
+//   ScanFrameIndex[frameCount]   - where each frame's points start
+//   ScanPose[frameCount]         - packed pose per frame
+//   LidarPoint[pointCount]       - all points, frame after frame
+//
+// Every section is located through the offsets in the header, so the
+// emulator can mmap the file and hand out pointers with no parsing.
+// --------------------------------------------------------------------
+static const char SCAN_FILE_MAGIC[8] = { 'R', 'V', 'R', 'S', 'C', 'A', 'N', '\0' };
+static const uint32_t SCAN_FILE_VERSION = 1;
+
+#pragma pack(push, 1)
+struct ScanFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t frameCount;
+    uint64_t pointCount;
+    uint64_t indexOffset;
+    uint64_t posesOffset;
+    uint64_t pointsOffset;
+};
+
+struct ScanFrameIndex {
+    uint64_t firstPoint;  // index into the points array
+    uint32_t pointCount;
+    uint32_t reserved;
+};
+
+struct ScanPose {
+    float posX;
+    float posY;
+    float posZ;
+    float rotX;
+    float rotY;
+    float rotZ;
+};
+#pragma pack(pop)
+
+// --------------------------------------------------------------------
+// data/roverN.dat -> data/roverN.scan
+// --------------------------------------------------------------------
+inline std::string scanFilePath(const std::string& datPath)
+{
+    const std::string ext = ".dat";
+    if (datPath.size() >= ext.size() &&
+        datPath.compare(datPath.size() - ext.size(), ext.size(), ext) == 0) {
+        return datPath.substr(0, datPath.size() - ext.size()) + ".scan";
+    }
+    return datPath + ".scan";
+}
+
+// --------------------------------------------------------------------
+// Read-only, memory-mapped view of a .scan file.
+// --------------------------------------------------------------------
+class ScanFile {
+public:
+    ScanFile() = default;
+    ScanFile(const ScanFile&) = delete;
+    ScanFile& operator=(const ScanFile&) = delete;
+    ~ScanFile() { close(); }
+
+    bool open(const std::string& path)
+    {
+        close();
+
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            std::cerr << "Error: cannot open scan file: " << path << "\n";
+            return false;
+        }
+
+        struct stat st;
+        if (fstat(fd, &st) < 0 || st.st_size < static_cast<off_t>(sizeof(ScanFileHeader))) {
+            std::cerr << "Error: scan file too small: " << path << "\n";
+            ::close(fd);
+            return false;
+        }
+
+        void* base = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (base == MAP_FAILED) {
+            std::cerr << "Error: cannot mmap scan file: " << path << "\n";
+            return false;
+        }
+        m_base = static_cast<const char*>(base);
+        m_size = static_cast<size_t>(st.st_size);
+
+        // Frames are replayed front to back
+        madvise(base, m_size, MADV_SEQUENTIAL);
+
+        if (!validate()) {
+            std::cerr << "Error: invalid or truncated scan file: " << path << "\n";
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    void close()
+    {
+        if (m_base) {
+            munmap(const_cast<char*>(m_base), m_size);
+        }
+        m_base = nullptr;
+        m_size = 0;
+        m_header = nullptr;
+    }
+
+    uint32_t frameCount() const { return m_header ? m_header->frameCount : 0; }
+    uint64_t pointCount() const { return m_header ? m_header->pointCount : 0; }
+
+    const ScanPose& pose(uint32_t frame) const { return m_poses[frame]; }
+    const LidarPoint* points(uint32_t frame) const { return m_points + m_index[frame].firstPoint; }
+    uint32_t pointCount(uint32_t frame) const { return m_index[frame].pointCount; }
+
+private:
+    bool validate()
+    {
+        m_header = reinterpret_cast<const ScanFileHeader*>(m_base);
+        if (std::memcmp(m_header->magic, SCAN_FILE_MAGIC, sizeof(SCAN_FILE_MAGIC)) != 0 ||
+            m_header->version != SCAN_FILE_VERSION) {
+            return false;
+        }
+
+        uint64_t frames = m_header->frameCount;
+        if (!sectionFits(m_header->indexOffset, frames * sizeof(ScanFrameIndex)) ||
+            !sectionFits(m_header->posesOffset, frames * sizeof(ScanPose)) ||
+            !sectionFits(m_header->pointsOffset, m_header->pointCount * sizeof(LidarPoint))) {
+            return false;
+        }
+
+        m_index = reinterpret_cast<const ScanFrameIndex*>(m_base + m_header->indexOffset);
+        m_poses = reinterpret_cast<const ScanPose*>(m_base + m_header->posesOffset);
+        m_points = reinterpret_cast<const LidarPoint*>(m_base + m_header->pointsOffset);
+
+        for (uint64_t i = 0; i < frames; ++i) {
+            if (m_index[i].firstPoint + m_index[i].pointCount > m_header->pointCount) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool sectionFits(uint64_t offset, uint64_t bytes) const
+    {
+        return offset <= m_size && bytes <= m_size - offset;
+    }
+
+    const char* m_base = nullptr;
+    size_t m_size = 0;
+    const ScanFileHeader* m_header = nullptr;
+    const ScanFrameIndex* m_index = nullptr;
+    const ScanPose* m_poses = nullptr;
+    const LidarPoint* m_points = nullptr;
+};
+
+#endif // SCAN_FORMAT_H
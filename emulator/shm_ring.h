@@ -0,0 +1,251 @@
+#ifndef SHM_RING_H
+#define SHM_RING_H
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <string>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "shm_ring_layout.h"
+
+// --------------------------------------------------------------------
+// Shared-memory ring per rover: the writer the emulator uses with --shm
+// and a reader for the transport benchmark. The layout is defined in
+// protocol/shm_ring_layout.h, shared with the visualization; this
+// header brings it into the emulator's (global) namespace.
+// --------------------------------------------------------------------
+using terrafirma::SHM_RING_MAGIC;
+using terrafirma::SHM_RING_VERSION;
+using terrafirma::SHM_STREAM_POSE;
+using terrafirma::SHM_STREAM_LIDAR;
+using terrafirma::SHM_STREAM_TELEM;
+using terrafirma::SHM_STREAM_STATE;
+using terrafirma::SHM_STREAM_PAD;
+using terrafirma::ShmRingHeader;
+using terrafirma::ShmRecordHeader;
+using terrafirma::shmRingName;
+using terrafirma::shmRingMappedSize;
+using terrafirma::shmRecordFits;
+
+static const uint64_t SHM_RING_DEFAULT_BYTES = 1 << 20;
+
+// --------------------------------------------------------------------
+// Producer side. Creates (replacing any stale one) and owns the shared
+// memory object; it is unlinked again on destruction.
+// --------------------------------------------------------------------
+class ShmRingWriter {
+public:
+    ~ShmRingWriter() { close(); }
+
+    bool create(const std::string& name, uint64_t capacity = SHM_RING_DEFAULT_BYTES)
+    {
+        close();
+        shm_unlink(name.c_str());
+        int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (fd < 0) {
+            std::cerr << "Error: cannot create shared memory " << name << ": " << std::strerror(errno) << "\n";
+            return false;
+        }
+        size_t size = shmRingMappedSize(capacity);
+        void* mapping = MAP_FAILED;
+        if (ftruncate(fd, static_cast<off_t>(size)) == 0) {
+            mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        }
+        ::close(fd);
+        if (mapping == MAP_FAILED) {
+            std::cerr << "Error: cannot map shared memory " << name << ": " << std::strerror(errno) << "\n";
+            shm_unlink(name.c_str());
+            return false;
+        }
+
+        m_name = name;
+        m_size = size;
+        m_ring = new (mapping) ShmRingHeader;
+        m_ring->capacity = capacity;
+        m_ring->writerPid = static_cast<int32_t>(getpid());
+        m_ring->readerPid.store(0, std::memory_order_relaxed);
+        m_ring->writePos.store(0, std::memory_order_relaxed);
+        m_ring->readPos.store(0, std::memory_order_relaxed);
+        m_ring->version = SHM_RING_VERSION;
+        std::atomic_thread_fence(std::memory_order_release);
+        m_ring->magic = SHM_RING_MAGIC;
+        return true;
+    }
+
+    void close()
+    {
+        if (m_ring) {
+            munmap(m_ring, m_size);
+            shm_unlink(m_name.c_str());
+            m_ring = nullptr;
+        }
+    }
+
+    // True while a live reader is attached. The PID check costs a
+    // syscall, so it is repeated at most once per second.
+    bool readerAttached()
+    {
+        if (!m_ring) {
+            return false;
+        }
+        auto now = std::chrono::steady_clock::now();
+        int32_t pid = m_ring->readerPid.load(std::memory_order_acquire);
+        if (pid != m_checkedPid || now - m_checkedAt > std::chrono::seconds(1)) {
+            m_checkedPid = pid;
+            m_checkedAt = now;
+            m_readerAlive = pid > 0 && (kill(pid, 0) == 0 || errno == EPERM);
+        }
+        return m_readerAlive;
+    }
+
+    // Largest payload write() accepts
+    size_t maxPayload() const { return m_ring ? m_ring->capacity / 4 : 0; }
+
+    // Appends one record gathered from two parts. Returns false (and
+    // writes nothing) if the reader is too far behind to make room.
+    bool write(uint16_t stream, const void* head, size_t headSize, const void* body, size_t bodySize)
+    {
+        size_t payload = headSize + bodySize;
+        if (!m_ring || payload > maxPayload()) {
+            return false;
+        }
+        uint64_t capacity = m_ring->capacity;
+        uint64_t need = alignRecord(payload);
+        uint64_t write = m_ring->writePos.load(std::memory_order_relaxed);
+        uint64_t offset = write & (capacity - 1);
+        uint64_t tail = capacity - offset;  // room before the end
+        uint64_t total = (tail < need) ? tail + need : need;
+
+        uint64_t read = m_ring->readPos.load(std::memory_order_acquire);
+        if (write + total - read > capacity) {
+            return false;
+        }
+
+        if (tail < need) {
+            ShmRecordHeader pad = { static_cast<uint32_t>(tail - sizeof(ShmRecordHeader)), SHM_STREAM_PAD, 0 };
+            std::memcpy(m_ring->data + offset, &pad, sizeof(pad));
+            offset = 0;
+        }
+        ShmRecordHeader record = { static_cast<uint32_t>(payload), stream, 0 };
+        char* out = m_ring->data + offset;
+        std::memcpy(out, &record, sizeof(record));
+        std::memcpy(out + sizeof(record), head, headSize);
+        if (bodySize > 0) {
+            std::memcpy(out + sizeof(record) + headSize, body, bodySize);
+        }
+        m_ring->writePos.store(write + total, std::memory_order_release);
+        return true;
+    }
+
+    static uint64_t alignRecord(size_t payload)
+    {
+        return (sizeof(ShmRecordHeader) + payload + 7) & ~uint64_t(7);
+    }
+
+private:
+    std::string m_name;
+    size_t m_size = 0;
+    ShmRingHeader* m_ring = nullptr;
+    int32_t m_checkedPid = 0;
+    bool m_readerAlive = false;
+    std::chrono::steady_clock::time_point m_checkedAt;
+};
+
+// --------------------------------------------------------------------
+// Consumer side (used by the transport benchmark; the visualization
+// has its own in visualization/src/network/ShmRing.h). Hands each
+// record to 'handler' in place.
+// --------------------------------------------------------------------
+class ShmRingReader {
+public:
+    ~ShmRingReader() { close(); }
+
+    bool open(const std::string& name)
+    {
+        close();
+        int fd = shm_open(name.c_str(), O_RDWR, 0);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat info;
+        void* mapping = MAP_FAILED;
+        if (fstat(fd, &info) == 0 && static_cast<size_t>(info.st_size) > offsetof(ShmRingHeader, data)) {
+            mapping = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        }
+        ::close(fd);
+        if (mapping == MAP_FAILED) {
+            return false;
+        }
+        m_size = static_cast<size_t>(info.st_size);
+        m_ring = static_cast<ShmRingHeader*>(mapping);
+        if (m_ring->magic != SHM_RING_MAGIC || m_ring->version != SHM_RING_VERSION ||
+            shmRingMappedSize(m_ring->capacity) != m_size) {
+            close();
+            return false;
+        }
+        // Start with what is written from now on
+        m_ring->readPos.store(m_ring->writePos.load(std::memory_order_acquire), std::memory_order_release);
+        m_ring->readerPid.store(static_cast<int32_t>(getpid()), std::memory_order_release);
+        return true;
+    }
+
+    void close()
+    {
+        if (m_ring) {
+            int32_t self = static_cast<int32_t>(getpid());
+            m_ring->readerPid.compare_exchange_strong(self, 0);
+            munmap(m_ring, m_size);
+            m_ring = nullptr;
+        }
+    }
+
+    // Calls handler(stream, payload, size) for every pending record and
+    // returns how many there were
+    template <typename Handler>
+    size_t poll(Handler&& handler)
+    {
+        uint64_t capacity = m_ring->capacity;
+        uint64_t read = m_ring->readPos.load(std::memory_order_relaxed);
+        uint64_t write = m_ring->writePos.load(std::memory_order_acquire);
+        size_t records = 0;
+        while (read < write) {
+            // A record outside the buffer means a corrupt ring: skip
+            // everything pending
+            const uint64_t offset = read & (capacity - 1);
+            ShmRecordHeader record;
+            if (!shmRecordFits(capacity, offset, 0)) {
+                read = write;
+                break;
+            }
+            const char* at = m_ring->data + offset;
+            std::memcpy(&record, at, sizeof(record));
+            if (!shmRecordFits(capacity, offset, record.size)) {
+                read = write;
+                break;
+            }
+            if (record.stream != SHM_STREAM_PAD) {
+                handler(record.stream, at + sizeof(record), static_cast<size_t>(record.size));
+                ++records;
+            }
+            read += ShmRingWriter::alignRecord(record.size);
+        }
+        m_ring->readPos.store(read, std::memory_order_release);
+        return records;
+    }
+
+private:
+    size_t m_size = 0;
+    ShmRingHeader* m_ring = nullptr;
+};
+
+#endif // SHM_RING_H
@@ -0,0 +1,382 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <cstring>
+#include <cstdlib>
+#include <cstdint>
+#include <iomanip>
+#include <time.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "rover_packets.h"
+#include "shm_ring.h"
+#include "udp_sender.h"
+#include "pacer.h"
+
+// --------------------------------------------------------------------
+// Same-host transport benchmark: UDP loopback vs the shared-memory ring.
+//
+// A sender thread offers synthetic LiDAR scans at a fixed rate (or as
+// fast as it can) for a few seconds, sending them the way the emulator
+// does: over UDP as path-MTU chunks with one sendmmsg per scan, or as a
+// single ring record. A receiver thread polls the way the visualization
+// does (drain everything, then sleep 1 ms), reassembles the chunks and
+// copies the points out. Reported per transport and rate: scans
+// delivered per second, scans lost (dropped by a full socket buffer or
+// refused by a full ring), the sender's CPU time per offered scan and
+// the receiver's per delivered scan.
+//
+// A second table compares sending each scan's chunks at once with
+// pacing them (emulator --pace) into a socket with the default receive
+// buffer, counting the datagrams the kernel dropped (SO_RXQ_OVFL).
+// --------------------------------------------------------------------
+
+static double threadCpuSeconds()
+{
+    timespec t;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t);
+    return static_cast<double>(t.tv_sec) + static_cast<double>(t.tv_nsec) * 1e-9;
+}
+
+struct BenchResult {
+    uint64_t offered = 0;     // scans the sender produced
+    uint64_t delivered = 0;   // scans the receiver completed
+    double seconds = 0.0;
+    double senderCpu = 0.0;
+    double receiverCpu = 0.0;
+    uint32_t overflows = 0;   // datagrams dropped by a full socket queue
+};
+
+// Socket settings and sender behaviour for one UDP run
+struct UdpSetup {
+    int receiveBuffer = 4 << 20;  // SO_RCVBUF, 0 = system default
+    size_t paceBurst = 0;         // token-bucket burst in bytes, 0 = whole scan at once
+};
+
+// recv() that also returns the socket's drop count (SO_RXQ_OVFL), which
+// the kernel attaches once it is non-zero
+static ssize_t receiveCounted(int sock, char* buffer, size_t size, uint32_t& overflows)
+{
+    iovec iov = { buffer, size };
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(uint32_t))];
+    msghdr msg;
+    std::memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    ssize_t n = recvmsg(sock, &msg, MSG_DONTWAIT);
+    for (cmsghdr* cmsg = n > 0 ? CMSG_FIRSTHDR(&msg) : nullptr; cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SO_RXQ_OVFL) {
+            std::memcpy(&overflows, CMSG_DATA(cmsg), sizeof(overflows));
+        }
+    }
+    return n;
+}
+
+// Collects chunks of the current scan; an unfinished scan is given up
+// when the next one starts (the benchmark never reorders)
+class ScanCollector {
+public:
+    void add(const char* data, size_t size)
+    {
+        if (size < LidarPacketHeaderView::SIZE) {
+            return;
+        }
+        LidarPacketHeaderView header(data);
+        uint32_t count = header.pointsInThisChunk();
+        size_t bytes = static_cast<size_t>(count) * sizeof(LidarPoint);
+        if (header.magic() != LIDAR_MAGIC || LidarPacketHeaderView::SIZE + bytes > size) {
+            return;
+        }
+        if (header.scanId() != m_scanId || m_chunks == 0) {
+            m_scanId = header.scanId();
+            m_chunks = 0;
+            m_points.clear();
+        }
+        size_t old = m_points.size();
+        m_points.resize(old + count);
+        std::memcpy(m_points.data() + old, data + LidarPacketHeaderView::SIZE, bytes);
+        if (++m_chunks == header.totalChunks()) {
+            ++m_delivered;
+            m_chunks = 0;
+        }
+    }
+
+    uint64_t delivered() const { return m_delivered; }
+
+private:
+    uint32_t m_scanId = 0;
+    uint32_t m_chunks = 0;
+    uint64_t m_delivered = 0;
+    std::vector<LidarPoint> m_points;
+};
+
+// Calls send(scanId, points) every 1/rate seconds until 'seconds' have
+// passed. Rate 0 means back to back, retrying a scan the transport
+// refused (full ring) instead of dropping it, so the ring's throughput
+// isn't hidden behind millions of refused writes.
+template <typename SendScan>
+static void runSender(const std::vector<LidarPoint>& points, double rate, double seconds,
+                      BenchResult& result, SendScan send)
+{
+    double cpu0 = threadCpuSeconds();
+    auto start = std::chrono::steady_clock::now();
+    auto end = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(seconds));
+    auto interval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(rate > 0.0 ? 1.0 / rate : 0.0));
+    auto next = start;
+    uint32_t scanId = 0;
+
+    while (true) {
+        auto now = std::chrono::steady_clock::now();
+        if (now >= end) {
+            break;
+        }
+        if (rate > 0.0) {
+            if (now < next) {
+                std::this_thread::sleep_until(std::min(next, end));
+                continue;
+            }
+            next += interval;
+        }
+        if (!send(scanId, points) && rate <= 0.0) {
+            std::this_thread::yield();
+            continue;
+        }
+        ++scanId;
+    }
+    result.offered = scanId;
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.senderCpu = threadCpuSeconds() - cpu0;
+}
+
+static LidarPacketHeader makeHeader(uint32_t scanId)
+{
+    LidarPacketHeader header;
+    std::memset(&header, 0, sizeof(header));
+    header.magic = LIDAR_MAGIC;
+    header.version = LIDAR_PROTOCOL_VERSION;
+    header.encoding = LIDAR_ENCODING_FLOAT32;
+    header.scanId = scanId;
+    return header;
+}
+
+static bool benchUdp(const std::vector<LidarPoint>& points, double rate, double seconds, const UdpSetup& setup,
+                     BenchResult& result)
+{
+    int rx = socket(AF_INET, SOCK_DGRAM, 0);
+    int tx = socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    int rcvbuf = setup.receiveBuffer;
+    if (rcvbuf > 0) {
+        setsockopt(rx, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+    }
+    int on = 1;
+    setsockopt(rx, SOL_SOCKET, SO_RXQ_OVFL, &on, sizeof(on));
+    if (rx < 0 || tx < 0 || bind(rx, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 ||
+        getsockname(rx, reinterpret_cast<sockaddr*>(&addr), &len) < 0 ||
+        connect(tx, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        std::cerr << "Error: cannot set up loopback UDP sockets: " << std::strerror(errno) << "\n";
+        return false;
+    }
+
+    const size_t maxPoints = (pathDatagramLimit(tx) - sizeof(LidarPacketHeader)) / sizeof(LidarPoint);
+    std::atomic<bool> stop(false);
+    ScanCollector collector;
+
+    std::thread receiver([&] {
+        std::vector<char> buffer(MAX_UDP_PAYLOAD);
+        double cpu0 = threadCpuSeconds();
+        while (true) {
+            bool stopping = stop.load();
+            ssize_t n;
+            while ((n = receiveCounted(rx, buffer.data(), buffer.size(), result.overflows)) > 0) {
+                collector.add(buffer.data(), static_cast<size_t>(n));
+            }
+            if (stopping) {
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        result.receiverCpu = threadCpuSeconds() - cpu0;
+    });
+
+    SendStats stats;
+    DatagramBatch batch;
+    std::vector<LidarPacketHeader> headers;
+    TokenBucketPacer pacer(setup.paceBurst);
+    // Paced scans are spread over most of the send interval, as in the emulator
+    auto window = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(rate > 0.0 ? 0.8 / rate : 0.0));
+    runSender(points, rate, seconds, result, [&](uint32_t scanId, const std::vector<LidarPoint>& scan) {
+        uint32_t totalChunks = static_cast<uint32_t>((scan.size() + maxPoints - 1) / maxPoints);
+        headers.assign(totalChunks, makeHeader(scanId));
+        auto chunkBytes = [&](uint32_t c) {
+            return sizeof(LidarPacketHeader) + std::min(maxPoints, scan.size() - c * maxPoints) * sizeof(LidarPoint);
+        };
+        for (uint32_t c = 0; c < totalChunks; ++c) {
+            headers[c].chunkIndex = c;
+            headers[c].totalChunks = totalChunks;
+            headers[c].firstPoint = static_cast<uint32_t>(c * maxPoints);
+            headers[c].scanPoints = static_cast<uint32_t>(scan.size());
+            headers[c].pointsInThisChunk = static_cast<uint32_t>((chunkBytes(c) - sizeof(LidarPacketHeader)) /
+                                                                 sizeof(LidarPoint));
+            toWire(headers[c]);
+        }
+        bool paced = setup.paceBurst > 0 && rate > 0.0;
+        if (paced) {
+            pacer.start(scan.size() * sizeof(LidarPoint) + totalChunks * sizeof(LidarPacketHeader),
+                        std::chrono::steady_clock::now(), window);
+        }
+        uint32_t c = 0;
+        while (c < totalChunks) {
+            auto now = std::chrono::steady_clock::now();
+            while (c < totalChunks && (!paced || pacer.admit(chunkBytes(c), now))) {
+                batch.add(&headers[c], sizeof(LidarPacketHeader), &scan[c * maxPoints],
+                          chunkBytes(c) - sizeof(LidarPacketHeader));
+                ++c;
+            }
+            batch.flush(tx, stats);
+            if (c < totalChunks) {
+                std::this_thread::sleep_until(pacer.readyAt(chunkBytes(c)));
+            }
+        }
+        return true;
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    stop = true;
+    receiver.join();
+    result.delivered = collector.delivered();
+    close(tx);
+    close(rx);
+    return true;
+}
+
+static bool benchShm(const std::vector<LidarPoint>& points, double rate, double seconds, uint64_t ringBytes,
+                     BenchResult& result)
+{
+    const std::string name = "/terrafirma_transport_bench";
+    ShmRingWriter writer;
+    ShmRingReader reader;
+    if (!writer.create(name, ringBytes) || !reader.open(name)) {
+        return false;
+    }
+    if (sizeof(LidarPacketHeader) + points.size() * sizeof(LidarPoint) > writer.maxPayload()) {
+        std::cerr << "Error: a scan of " << points.size() << " points exceeds the ring's record limit\n";
+        return false;
+    }
+
+    std::atomic<bool> stop(false);
+    ScanCollector collector;
+
+    std::thread receiver([&] {
+        double cpu0 = threadCpuSeconds();
+        while (true) {
+            bool stopping = stop.load();
+            reader.poll([&](uint16_t, const char* data, size_t size) { collector.add(data, size); });
+            if (stopping) {
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        result.receiverCpu = threadCpuSeconds() - cpu0;
+    });
+
+    runSender(points, rate, seconds, result, [&](uint32_t scanId, const std::vector<LidarPoint>& scan) {
+        LidarPacketHeader header = makeHeader(scanId);
+        header.totalChunks = 1;
+        header.pointsInThisChunk = static_cast<uint32_t>(scan.size());
+        header.scanPoints = header.pointsInThisChunk;
+        toWire(header);
+        return writer.write(SHM_STREAM_LIDAR, &header, sizeof(header), scan.data(), scan.size() * sizeof(LidarPoint));
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    stop = true;
+    receiver.join();
+    result.delivered = collector.delivered();
+    return true;
+}
+
+static void report(const char* transport, double rate, const BenchResult& r, bool showOverflows = false)
+{
+    double offered = static_cast<double>(r.offered ? r.offered : 1);
+    double delivered = static_cast<double>(r.delivered ? r.delivered : 1);
+    std::cout << std::left << std::setw(9) << transport << std::right << std::fixed << std::setw(6);
+    if (rate > 0.0) {
+        std::cout << std::setprecision(0) << rate;
+    } else {
+        std::cout << "max";
+    }
+    std::cout << std::setprecision(0) << std::setw(12) << (r.delivered / r.seconds)
+              << std::setprecision(1) << std::setw(9)
+              << (r.offered ? 100.0 * static_cast<double>(r.offered - std::min(r.offered, r.delivered)) / r.offered : 0.0)
+              << " %" << std::setprecision(2) << std::setw(12) << (r.senderCpu * 1e6 / offered)
+              << std::setw(12) << (r.receiverCpu * 1e6 / delivered);
+    if (showOverflows) {
+        std::cout << std::setw(11) << r.overflows;
+    }
+    std::cout << "\n";
+}
+
+int main(int argc, char** argv)
+{
+    size_t pointCount = (argc >= 2) ? std::strtoul(argv[1], nullptr, 10) : 1152;
+    double seconds = (argc >= 3) ? std::strtod(argv[2], nullptr) : 2.0;
+    uint64_t ringBytes = (argc >= 4) ? std::strtoull(argv[3], nullptr, 10) : SHM_RING_DEFAULT_BYTES;
+    if (pointCount == 0 || seconds <= 0.0 || ringBytes == 0 || (ringBytes & (ringBytes - 1)) != 0) {
+        std::cerr << "Usage: " << argv[0] << " [pointsPerScan] [secondsPerRun] [ringBytes (power of two)]\n";
+        return 1;
+    }
+
+    std::vector<LidarPoint> points(pointCount);
+    for (size_t i = 0; i < pointCount; ++i) {
+        points[i] = { static_cast<float>(i % 97), static_cast<float>(i % 89), static_cast<float>(i % 13) };
+    }
+
+    std::cout << pointCount << " points per scan ("
+              << (sizeof(LidarPacketHeader) + pointCount * sizeof(LidarPoint)) / 1024 << " KB), "
+              << seconds << " s per run, " << ringBytes / 1024 << " KB ring\n\n";
+    std::cout << "transport  rate  delivered/s     lost   send us/scan  recv us/scan\n";
+
+    const double rates[] = { 100.0, 1000.0, 10000.0, 0.0 };
+    for (double rate : rates) {
+        BenchResult udp, shm;
+        if (!benchUdp(points, rate, seconds, UdpSetup(), udp) || !benchShm(points, rate, seconds, ringBytes, shm)) {
+            return 1;
+        }
+        report("udp", rate, udp);
+        report("shm", rate, shm);
+    }
+
+    // Bursts vs pacing into a default-sized receive buffer, 16 KB bursts
+    std::cout << "\nLiDAR pacing, default receive buffer, 16 KB bursts\n";
+    std::cout << "send       rate  delivered/s     lost   send us/scan  recv us/scan  overflows\n";
+    const double pacedRates[] = { 10.0, 100.0 };
+    for (double rate : pacedRates) {
+        UdpSetup burst, paced;
+        burst.receiveBuffer = paced.receiveBuffer = 0;
+        paced.paceBurst = 16384;
+        BenchResult burstResult, pacedResult;
+        if (!benchUdp(points, rate, seconds, burst, burstResult) ||
+            !benchUdp(points, rate, seconds, paced, pacedResult)) {
+            return 1;
+        }
+        report("burst", rate, burstResult, true);
+        report("paced", rate, pacedResult, true);
+    }
+    return 0;
+}
@@ -0,0 +1,240 @@
+#ifndef UDP_SENDER_H
+#define UDP_SENDER_H
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "latency_stats.h"
+
+#define LOOPBACK_ADDR "127.0.0.1"
+
+// Largest UDP payload over IPv4 (65535 minus the IP and UDP headers)
+static const size_t MAX_UDP_PAYLOAD = 65507;
+static const size_t IPV4_UDP_HEADER_BYTES = 28;
+
+// --------------------------------------------------------------------
+// Simple function to create a UDP socket (IPv4, non-blocking).
+// --------------------------------------------------------------------
+inline int createUDPSocket()
+{
+    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sock < 0) {
+        std::cerr << "Error: cannot create UDP socket.\n";
+        std::exit(EXIT_FAILURE);
+    }
+    return sock;
+}
+
+// --------------------------------------------------------------------
+// Creates a UDP socket connected to the given port on localhost, so
+// sends carry no per-call address. Returns -1 on error.
+// --------------------------------------------------------------------
+inline int connectUDPSocket(int port)
+{
+    int sock = createUDPSocket();
+
+    sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = inet_addr(LOOPBACK_ADDR);
+
+    if (connect(sock, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        std::cerr << "Error: cannot connect UDP socket to port " << port << "\n";
+        close(sock);
+        return -1;
+    }
+    return sock;
+}
+
+// --------------------------------------------------------------------
+// Largest datagram a connected socket can send without IP
+// fragmentation: the route's MTU minus the IPv4 and UDP headers, so
+// 65507 on loopback and 1472 on plain Ethernet. Falls back to the
+// Ethernet size if the kernel doesn't report an MTU.
+// --------------------------------------------------------------------
+inline size_t pathDatagramLimit(int sock)
+{
+    int mtu = 0;
+    socklen_t len = sizeof(mtu);
+    if (getsockopt(sock, IPPROTO_IP, IP_MTU, &mtu, &len) < 0 ||
+        mtu <= static_cast<int>(IPV4_UDP_HEADER_BYTES)) {
+        return 1500 - IPV4_UDP_HEADER_BYTES;
+    }
+    return std::min(static_cast<size_t>(mtu) - IPV4_UDP_HEADER_BYTES, MAX_UDP_PAYLOAD);
+}
+
+// --------------------------------------------------------------------
+// Raises the open-file soft limit so large fleets (four sockets per
+// rover) fit. Returns false if the hard limit is too low.
+// --------------------------------------------------------------------
+inline bool ensureFileLimit(rlim_t needed)
+{
+    rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) < 0) {
+        return false;
+    }
+    if (limit.rlim_cur >= needed) {
+        return true;
+    }
+    limit.rlim_cur = (limit.rlim_max == RLIM_INFINITY || limit.rlim_max >= needed) ? needed : limit.rlim_max;
+    return setrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur >= needed;
+}
+
+// --------------------------------------------------------------------
+// Send-side counters, accumulated across all rovers.
+// --------------------------------------------------------------------
+struct SendStats {
+    uint64_t frames = 0;      // rover ticks that sent anything
+    uint64_t datagrams = 0;
+    uint64_t bytes = 0;
+    uint64_t syscalls = 0;
+    uint64_t refused = 0;     // dropped because nobody listens on the port
+    uint64_t errors = 0;
+    uint64_t underruns = 0;   // ticks where a rover's next frame wasn't decoded yet
+    uint64_t impairDropped = 0;     // lost by the impairment layer (drop / burst)
+    uint64_t impairDuplicated = 0;
+    uint64_t impairReordered = 0;   // released out of order
+    uint64_t impairOverflow = 0;    // tail-dropped waiting for bandwidth
+    uint64_t lidarPoints = 0;       // points in the frames sent
+    uint64_t lidarSuppressed = 0;   // of those, left out by the delta filter
+    uint64_t shmRecords = 0;        // messages written to shared memory (not in 'datagrams')
+    uint64_t shmFull = 0;           // dropped because the reader fell a ring behind
+    uint64_t pacedBursts = 0;       // LiDAR sends released by the pacer (--pace)
+    uint64_t pacedLate = 0;         // chunks the pacer hadn't sent when the next tick began
+    double sendMicros = 0.0;  // time spent building and sending
+    LatencySamples poseDelay; // tick start to pose send, one sample per pose (--stats only)
+
+    void reset() { *this = SendStats(); }
+};
+
+// --------------------------------------------------------------------
+// Connected UDP sockets report ICMP port-unreachable as ECONNREFUSED on
+// a later send. That only means the visualization isn't listening yet,
+// so it is counted apart from real errors.
+// --------------------------------------------------------------------
+inline void countSendError(SendStats& stats, uint64_t datagrams)
+{
+    if (errno == ECONNREFUSED) {
+        stats.refused += datagrams;
+    } else {
+        stats.errors += datagrams;
+    }
+}
+
+// --------------------------------------------------------------------
+// Sends one datagram on a connected socket, counting the syscall.
+// --------------------------------------------------------------------
+inline void sendDatagram(int sock, const void* data, size_t size, SendStats& stats)
+{
+    ++stats.syscalls;
+    ssize_t n = send(sock, data, size, 0);
+    if (n < 0) {
+        countSendError(stats, 1);
+        return;
+    }
+    ++stats.datagrams;
+    stats.bytes += static_cast<uint64_t>(n);
+}
+
+// Same, gathered from two parts (e.g. a prefix header and a packet)
+inline void sendDatagram(int sock, const void* head, size_t headSize, const void* body, size_t bodySize,
+                         SendStats& stats)
+{
+    iovec parts[2];
+    parts[0].iov_base = const_cast<void*>(head);
+    parts[0].iov_len = headSize;
+    parts[1].iov_base = const_cast<void*>(body);
+    parts[1].iov_len = bodySize;
+    msghdr msg;
+    std::memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = parts;
+    msg.msg_iovlen = (bodySize > 0) ? 2 : 1;
+
+    ++stats.syscalls;
+    ssize_t n = sendmsg(sock, &msg, 0);
+    if (n < 0) {
+        countSendError(stats, 1);
+        return;
+    }
+    ++stats.datagrams;
+    stats.bytes += static_cast<uint64_t>(n);
+}
+
+// --------------------------------------------------------------------
+// Queue of datagrams for one connected socket, flushed with sendmmsg.
+//
+// Each datagram is gathered from a header and a body buffer, so LiDAR
+// points are sent straight from the frame without copying into a
+// packet struct. Queued buffers must stay valid until flush().
+// --------------------------------------------------------------------
+class DatagramBatch {
+public:
+    void clear()
+    {
+        m_iov.clear();
+        m_msgs.clear();
+    }
+
+    void add(const void* head, size_t headSize, const void* body, size_t bodySize)
+    {
+        iovec parts[2];
+        parts[0].iov_base = const_cast<void*>(head);
+        parts[0].iov_len = headSize;
+        parts[1].iov_base = const_cast<void*>(body);
+        parts[1].iov_len = bodySize;
+        m_iov.push_back(parts[0]);
+        m_iov.push_back(parts[1]);
+
+        mmsghdr msg;
+        std::memset(&msg, 0, sizeof(msg));
+        msg.msg_hdr.msg_iovlen = (bodySize > 0) ? 2 : 1;
+        m_msgs.push_back(msg);
+    }
+
+    size_t size() const { return m_msgs.size(); }
+
+    // Sends everything queued, in order, then empties the batch.
+    // On error the rest of the batch is dropped.
+    void flush(int sock, SendStats& stats)
+    {
+        // iovec storage may have moved while queuing; wire it up now
+        for (size_t i = 0; i < m_msgs.size(); ++i) {
+            m_msgs[i].msg_hdr.msg_iov = &m_iov[i * 2];
+        }
+
+        size_t sent = 0;
+        while (sent < m_msgs.size()) {
+            unsigned int count = static_cast<unsigned int>(std::min<size_t>(m_msgs.size() - sent, UIO_MAXIOV));
+            ++stats.syscalls;
+            int n = sendmmsg(sock, &m_msgs[sent], count, 0);
+            if (n < 0) {
+                countSendError(stats, m_msgs.size() - sent);
+                break;
+            }
+            for (int i = 0; i < n; ++i) {
+                stats.bytes += m_msgs[sent + i].msg_len;
+            }
+            stats.datagrams += static_cast<uint64_t>(n);
+            sent += static_cast<size_t>(n);
+        }
+        clear();
+    }
+
+private:
+    std::vector<iovec> m_iov;  // two entries per message
+    std::vector<mmsghdr> m_msgs;
+};
+
+#endif // UDP_SENDER_H
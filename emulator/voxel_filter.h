@@ -0,0 +1,125 @@
+#ifndef VOXEL_FILTER_H
+#define VOXEL_FILTER_H
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "rover_packets.h"
+
+// --------------------------------------------------------------------
+// Sender-side delta filter for LiDAR scans.
+//
+// Space is cut into cubic voxels; a point is only sent if no point in
+// its voxel was sent during the last 'windowFrames' frames. A slow or
+// parked rover therefore sends little more than the newly seen ground,
+// and a voxel is refreshed once per window, which also repairs chunks
+// lost on the way.
+//
+// The voxel -> last-sent-frame map is an open-addressing hash table
+// (linear probing). Expired entries count as empty and are dropped when
+// the table grows, so its size follows the area seen in one window.
+// Frames may be skipped (only the scans actually sent are filtered);
+// going back (seek, loop) or skipping a whole window starts over with
+// an empty table.
+// --------------------------------------------------------------------
+class VoxelDeltaFilter {
+public:
+    VoxelDeltaFilter(float voxelSize, uint32_t windowFrames)
+        : m_scale(1.0f / voxelSize), m_window(windowFrames)
+    {
+        m_slots.assign(size_t(1) << m_bits, Slot());
+    }
+
+    // Copies to 'out' the points of frame 'frameIndex' that fall in
+    // voxels not sent within the window, and marks those voxels sent.
+    // Returns the number of points copied. 'out' may be 'points'.
+    size_t filter(const LidarPoint* points, size_t count, uint32_t frameIndex, LidarPoint* out)
+    {
+        if (frameIndex <= m_lastFrame || frameIndex - m_lastFrame >= m_window) {
+            m_slots.assign(m_slots.size(), Slot());
+            m_used = 0;
+        }
+        m_lastFrame = frameIndex;
+
+        size_t kept = 0;
+        for (size_t i = 0; i < count; ++i) {
+            if ((m_used + 1) * 2 > m_slots.size()) {
+                grow(frameIndex);
+            }
+            uint64_t key = voxelKey(points[i]);
+            Slot& slot = find(key);
+            if (slot.key != EMPTY && frameIndex - slot.frame < m_window) {
+                continue;  // voxel sent recently
+            }
+            if (slot.key == EMPTY) {
+                ++m_used;
+            }
+            slot.key = key;
+            slot.frame = frameIndex;
+            out[kept++] = points[i];
+        }
+        return kept;
+    }
+
+private:
+    static const uint64_t EMPTY = ~uint64_t(0);
+
+    struct Slot {
+        uint64_t key = EMPTY;
+        uint32_t frame = 0;
+    };
+
+    // 21 bits per axis, so +-1M voxels around the origin
+    uint64_t voxelKey(const LidarPoint& p) const
+    {
+        const int64_t bias = int64_t(1) << 20;
+        const uint64_t mask = (uint64_t(1) << 21) - 1;
+        uint64_t x = static_cast<uint64_t>(static_cast<int64_t>(std::floor(p.x * m_scale)) + bias) & mask;
+        uint64_t y = static_cast<uint64_t>(static_cast<int64_t>(std::floor(p.y * m_scale)) + bias) & mask;
+        uint64_t z = static_cast<uint64_t>(static_cast<int64_t>(std::floor(p.z * m_scale)) + bias) & mask;
+        return (x << 42) | (y << 21) | z;
+    }
+
+    Slot& find(uint64_t key)
+    {
+        size_t mask = m_slots.size() - 1;
+        size_t i = static_cast<size_t>((key * 0x9E3779B97F4A7C15ULL) >> (64 - m_bits));
+        while (m_slots[i].key != EMPTY && m_slots[i].key != key) {
+            i = (i + 1) & mask;
+        }
+        return m_slots[i];
+    }
+
+    // Rehashes without the expired entries, doubling the table only if
+    // what's left would still fill more than a quarter of it
+    void grow(uint32_t frameIndex)
+    {
+        std::vector<Slot> old;
+        old.swap(m_slots);
+        size_t live = 0;
+        for (const Slot& slot : old) {
+            live += (slot.key != EMPTY && frameIndex - slot.frame < m_window);
+        }
+        if (live * 4 > old.size()) {
+            ++m_bits;
+        }
+        m_slots.assign(size_t(1) << m_bits, Slot());
+        m_used = 0;
+        for (const Slot& slot : old) {
+            if (slot.key != EMPTY && frameIndex - slot.frame < m_window) {
+                find(slot.key) = slot;
+                ++m_used;
+            }
+        }
+    }
+
+    float m_scale;              // 1 / voxel size
+    uint32_t m_window;          // frames a sent voxel stays suppressed
+    uint32_t m_lastFrame = UINT32_MAX;
+    unsigned m_bits = 12;       // table size is 2^m_bits
+    size_t m_used = 0;          // occupied slots, live or expired
+    std::vector<Slot> m_slots;
+};
+
+#endif // VOXEL_FILTER_H
@@ -0,0 +1,304 @@
+#ifndef TERRAFIRMA_ROVER_PROTOCOL_H
+#define TERRAFIRMA_ROVER_PROTOCOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// --------------------------------------------------------------------
+// Rover wire protocol, shared by the emulator (sender) and the
+// visualization (receiver). Each packet is defined exactly once here,
+// as a field list; from that list this header generates
+//
+//   <Packet>          the packed struct a sender fills in and sends
+//   <Packet>View      read-only accessors over a received buffer: each
+//                     field is loaded from its compile-time offset with
+//                     memcpy (no alignment requirement on the buffer)
+//                     and converted from wire to host byte order
+//   toWire(<Packet>&) converts a filled struct to wire byte order just
+//                     before it is sent (fromWire() is the inverse)
+//
+// Every multi-byte field is little-endian on the wire. On little-endian
+// hosts the conversions compile to nothing, and a view's accessors to a
+// single unaligned load.
+//
+// The sizes are pinned by static_asserts below: changing a packet means
+// bumping its protocol version, not just editing a field list.
+// --------------------------------------------------------------------
+
+namespace terrafirma {
+
+// --------------------------------------------------------------------
+// Ports. Rover N uses base + N on each per-rover stream; with the
+// multiplexed ingest every rover and stream goes to INGEST_PORT.
+// --------------------------------------------------------------------
+constexpr int POSE_PORT_BASE  = 9000;
+constexpr int LIDAR_PORT_BASE = 10000;
+constexpr int TELEM_PORT_BASE = 11000;
+constexpr int CMD_PORT_BASE   = 8000;
+constexpr int INGEST_PORT     = 7000;
+
+// --------------------------------------------------------------------
+// Byte order
+// --------------------------------------------------------------------
+#if defined(__BYTE_ORDER__) && defined(__ORDER_LITTLE_ENDIAN__)
+constexpr bool HOST_IS_LITTLE_ENDIAN = (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__);
+#elif defined(_WIN32)
+constexpr bool HOST_IS_LITTLE_ENDIAN = true;
+#else
+#error "rover_protocol.h: cannot determine the host byte order"
+#endif
+
+namespace wire {
+
+inline uint16_t byteSwap(uint16_t v) { return static_cast<uint16_t>((v >> 8) | (v << 8)); }
+inline uint32_t byteSwap(uint32_t v)
+{
+    return ((v & 0x000000FFu) << 24) | ((v & 0x0000FF00u) << 8) |
+           ((v & 0x00FF0000u) >> 8)  | ((v & 0xFF000000u) >> 24);
+}
+inline uint64_t byteSwap(uint64_t v)
+{
+    return (static_cast<uint64_t>(byteSwap(static_cast<uint32_t>(v))) << 32) |
+           byteSwap(static_cast<uint32_t>(v >> 32));
+}
+
+template <size_t N> struct UnsignedOfSize;
+template <> struct UnsignedOfSize<2> { using type = uint16_t; };
+template <> struct UnsignedOfSize<4> { using type = uint32_t; };
+template <> struct UnsignedOfSize<8> { using type = uint64_t; };
+
+// Converts a field between host and wire order (the same operation in
+// both directions)
+template <typename T>
+inline T swapIfBigEndian(T value)
+{
+    static_assert(std::is_arithmetic<T>::value, "wire fields are plain numbers");
+    if constexpr (HOST_IS_LITTLE_ENDIAN || sizeof(T) == 1) {
+        return value;
+    } else {
+        typename UnsignedOfSize<sizeof(T)>::type bits;
+        std::memcpy(&bits, &value, sizeof(T));
+        bits = byteSwap(bits);
+        std::memcpy(&value, &bits, sizeof(T));
+        return value;
+    }
+}
+
+// Loads a field stored in wire order at 'data', which may be unaligned
+template <typename T>
+inline T load(const char* data)
+{
+    T value;
+    std::memcpy(&value, data, sizeof(T));
+    return swapIfBigEndian(value);
+}
+
+} // namespace wire
+
+// --------------------------------------------------------------------
+// Generators. FIELDS(X) must call X(type, name) once per field, in wire
+// order.
+// --------------------------------------------------------------------
+#define TF_WIRE_MEMBER(type, name) type name;
+
+#define TF_WIRE_ACCESSOR(type, name) \
+    type name() const { return ::terrafirma::wire::load<type>(m_data + offsetof(Packet, name)); }
+
+#define TF_WIRE_SWAP(type, name) packet.name = ::terrafirma::wire::swapIfBigEndian<type>(packet.name);
+
+#define TF_WIRE_STRUCT(Name, FIELDS) \
+    struct Name { FIELDS(TF_WIRE_MEMBER) };
+
+#define TF_WIRE_CODEC(Name, FIELDS, wireSize)                                           \
+    static_assert(sizeof(Name) == (wireSize), #Name " does not match its wire size");  \
+    static_assert(alignof(Name) == 1, #Name " must be packed");                        \
+    static_assert(std::is_trivially_copyable<Name>::value, #Name " must be POD");      \
+    inline void toWire(Name& packet) { FIELDS(TF_WIRE_SWAP) (void)packet; }             \
+    inline void fromWire(Name& packet) { toWire(packet); }                             \
+    class Name##View {                                                                 \
+    public:                                                                            \
+        using Packet = Name;                                                           \
+        static constexpr size_t SIZE = sizeof(Name);                                   \
+        /* 'data' must hold at least SIZE bytes */                                     \
+        explicit Name##View(const char* data) : m_data(data) {}                        \
+        FIELDS(TF_WIRE_ACCESSOR)                                                       \
+        const char* data() const { return m_data; }                                    \
+        /* The whole packet, in host order */                                          \
+        Name read() const                                                              \
+        {                                                                              \
+            Name packet;                                                               \
+            std::memcpy(&packet, m_data, SIZE);                                        \
+            fromWire(packet);                                                          \
+            return packet;                                                             \
+        }                                                                              \
+    private:                                                                           \
+        const char* m_data;                                                            \
+    };
+
+// --------------------------------------------------------------------
+// Multiplexed ingest (emulator --mux).
+//
+// Every rover sends all its streams to INGEST_PORT, each datagram
+// prefixed with a MuxHeader that names the rover and stream; the packet
+// follows unchanged. The per-stream sequence numbers are the ones
+// already inside each packet.
+// --------------------------------------------------------------------
+constexpr uint16_t MUX_MAGIC = 0x584D;  // "MX" on the wire
+constexpr uint8_t MUX_PROTOCOL_VERSION = 1;
+
+constexpr uint8_t MUX_STREAM_POSE = 1;   // PosePacket
+constexpr uint8_t MUX_STREAM_LIDAR = 2;  // LidarPacketHeader + points
+constexpr uint8_t MUX_STREAM_TELEM = 3;  // VehicleTelem
+constexpr uint8_t MUX_STREAM_STATE = 4;  // StatePacket
+
+#define TF_MUX_HEADER_FIELDS(X) \
+    X(uint16_t, magic)          /* MUX_MAGIC */ \
+    X(uint8_t, version)         /* MUX_PROTOCOL_VERSION */ \
+    X(uint8_t, stream)          /* MUX_STREAM_* */ \
+    X(uint32_t, roverId)
+
+// --------------------------------------------------------------------
+// Pose packet. Every packet type carries a 'sequence' that counts the
+// datagrams a rover has sent on that stream, so the receiver can tell
+// loss, reordering and duplicates apart.
+// --------------------------------------------------------------------
+#define TF_POSE_PACKET_FIELDS(X) \
+    X(double, timestamp) \
+    X(float, posX) \
+    X(float, posY) \
+    X(float, posZ) \
+    X(float, rotXdeg) \
+    X(float, rotYdeg) \
+    X(float, rotZdeg) \
+    X(uint32_t, sequence)
+
+// --------------------------------------------------------------------
+// LiDAR chunk.
+//
+// Every chunk starts with a versioned header. 'encoding' says how the
+// points that follow are stored:
+//   LIDAR_ENCODING_FLOAT32  LidarPoint (3 floats, 12 bytes)
+//   LIDAR_ENCODING_INT16    LidarPointQ16 (3 int16, 6 bytes); the point
+//                           is origin + q * resolution, with origin and
+//                           resolution taken from this chunk's header
+//
+// With LIDAR_FLAG_DELTA the scan only carries points in voxels that
+// weren't sent recently (emulator --delta); 'suppressedPoints' says how
+// many of the full scan's points were left out.
+//
+// 'scanId' numbers the rover's scans; all chunks of a scan share it.
+// A scan is split into as many chunks as it takes to keep each datagram
+// (header + points) within the sender's chunk size (--chunk-bytes).
+// Chunks needn't hold the same number of points (a quantized scan can
+// mix encodings), so each says where its points go: 'firstPoint' is the
+// index of its first point among the scan's 'scanPoints'.
+// --------------------------------------------------------------------
+constexpr uint16_t LIDAR_MAGIC = 0x4C44;  // "DL" on the wire
+constexpr uint8_t LIDAR_PROTOCOL_VERSION = 5;
+
+constexpr uint8_t LIDAR_ENCODING_FLOAT32 = 0;
+constexpr uint8_t LIDAR_ENCODING_INT16 = 1;
+
+constexpr uint16_t LIDAR_FLAG_DELTA = 0x0001;
+
+#define TF_LIDAR_HEADER_FIELDS(X) \
+    X(uint16_t, magic)             /* LIDAR_MAGIC */ \
+    X(uint8_t, version)            /* LIDAR_PROTOCOL_VERSION */ \
+    X(uint8_t, encoding)           /* LIDAR_ENCODING_* */ \
+    X(uint16_t, flags)             /* LIDAR_FLAG_* */ \
+    X(uint16_t, reserved)          /* zero */ \
+    X(double, timestamp) \
+    X(uint32_t, scanId) \
+    X(uint32_t, sequence)          /* per-rover LiDAR datagram counter */ \
+    X(uint32_t, chunkIndex) \
+    X(uint32_t, totalChunks) \
+    X(uint32_t, pointsInThisChunk) \
+    X(uint32_t, suppressedPoints)  /* whole scan, repeated in every chunk */ \
+    X(uint32_t, firstPoint)        /* offset of this chunk's points in the scan */ \
+    X(uint32_t, scanPoints)        /* whole scan, repeated in every chunk */ \
+    X(float, originX)              /* LIDAR_ENCODING_INT16 only */ \
+    X(float, originY) \
+    X(float, originZ) \
+    X(float, resolution)           /* meters per quantization step */
+
+#define TF_LIDAR_POINT_FIELDS(X) \
+    X(float, x) \
+    X(float, y) \
+    X(float, z)
+
+// Quantized point, relative to the chunk origin
+#define TF_LIDAR_POINT_Q16_FIELDS(X) \
+    X(int16_t, x) \
+    X(int16_t, y) \
+    X(int16_t, z)
+
+// --------------------------------------------------------------------
+// Telemetry packet
+// --------------------------------------------------------------------
+#define TF_VEHICLE_TELEM_FIELDS(X) \
+    X(double, timestamp) \
+    X(uint8_t, buttonStates)  /* bits 0..3 represent buttons 0..3 */ \
+    X(uint32_t, sequence)
+
+// --------------------------------------------------------------------
+// Combined pose + telemetry packet (emulator --state): one datagram per
+// rover and tick instead of a PosePacket and a VehicleTelem. It goes
+// to the pose stream and is told apart from a PosePacket by its size.
+// Without STATE_FLAG_POSE (no frame replayed yet) only the buttons are
+// valid. 'sequence' counts state packets.
+// --------------------------------------------------------------------
+constexpr uint8_t STATE_FLAG_POSE = 0x01;
+
+#define TF_STATE_PACKET_FIELDS(X) \
+    X(double, timestamp) \
+    X(float, posX) \
+    X(float, posY) \
+    X(float, posZ) \
+    X(float, rotXdeg) \
+    X(float, rotYdeg) \
+    X(float, rotZdeg) \
+    X(uint8_t, buttonStates) \
+    X(uint8_t, flags)         /* STATE_FLAG_* */ \
+    X(uint32_t, sequence)
+
+// --------------------------------------------------------------------
+// Generated structs, views and conversions
+// --------------------------------------------------------------------
+#pragma pack(push, 1)
+TF_WIRE_STRUCT(MuxHeader, TF_MUX_HEADER_FIELDS)
+TF_WIRE_STRUCT(PosePacket, TF_POSE_PACKET_FIELDS)
+TF_WIRE_STRUCT(LidarPacketHeader, TF_LIDAR_HEADER_FIELDS)
+TF_WIRE_STRUCT(LidarPoint, TF_LIDAR_POINT_FIELDS)
+TF_WIRE_STRUCT(LidarPointQ16, TF_LIDAR_POINT_Q16_FIELDS)
+TF_WIRE_STRUCT(VehicleTelem, TF_VEHICLE_TELEM_FIELDS)
+TF_WIRE_STRUCT(StatePacket, TF_STATE_PACKET_FIELDS)
+#pragma pack(pop)
+
+TF_WIRE_CODEC(MuxHeader, TF_MUX_HEADER_FIELDS, 8)
+TF_WIRE_CODEC(PosePacket, TF_POSE_PACKET_FIELDS, 36)
+TF_WIRE_CODEC(LidarPacketHeader, TF_LIDAR_HEADER_FIELDS, 64)
+TF_WIRE_CODEC(LidarPoint, TF_LIDAR_POINT_FIELDS, 12)
+TF_WIRE_CODEC(LidarPointQ16, TF_LIDAR_POINT_Q16_FIELDS, 6)
+TF_WIRE_CODEC(VehicleTelem, TF_VEHICLE_TELEM_FIELDS, 13)
+TF_WIRE_CODEC(StatePacket, TF_STATE_PACKET_FIELDS, 38)
+
+// Offsets the receivers rely on
+static_assert(offsetof(LidarPacketHeader, pointsInThisChunk) == 32, "LiDAR header layout changed");
+static_assert(offsetof(StatePacket, buttonStates) == 32, "state packet layout changed");
+
+// State and pose packets share a stream and are told apart by size
+static_assert(sizeof(StatePacket) != sizeof(PosePacket), "state and pose packets must differ in size");
+
+// Bytes per point for a LIDAR_ENCODING_*, 0 if unknown
+constexpr size_t lidarPointSize(uint8_t encoding)
+{
+    return encoding == LIDAR_ENCODING_FLOAT32 ? sizeof(LidarPoint)
+         : encoding == LIDAR_ENCODING_INT16   ? sizeof(LidarPointQ16)
+         : 0;
+}
+
+} // namespace terrafirma
+
+#endif // TERRAFIRMA_ROVER_PROTOCOL_H
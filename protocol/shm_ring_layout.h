@@ -0,0 +1,101 @@
+#ifndef TERRAFIRMA_SHM_RING_LAYOUT_H
+#define TERRAFIRMA_SHM_RING_LAYOUT_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "rover_protocol.h"
+
+// --------------------------------------------------------------------
+// Same-host transport: one POSIX shared-memory ring per rover. Its
+// layout is defined once here, for the emulator (writer, and a reader
+// in the transport benchmark) and the visualization (reader).
+//
+// The emulator (single producer) appends records; the visualization
+// (single consumer) reads them in place. Each record is one message in
+// its UDP wire format (PosePacket, VehicleTelem, StatePacket, or a LiDAR
+// scan as a single chunk), behind an 8-byte record header:
+//
+//   uint32 size     payload bytes
+//   uint16 stream   SHM_STREAM_*
+//   uint16 reserved
+//
+// Records are 8-byte aligned and never wrap: if one doesn't fit before
+// the end of the buffer, a SHM_STREAM_PAD record fills the rest and the
+// record starts at offset 0. writePos and readPos are byte counters
+// that only grow; each side owns one and reads the other's with
+// acquire ordering, so no locks are needed.
+//
+// The reader publishes its PID while attached. The emulator only uses
+// the ring while a live reader is attached and sends over UDP otherwise,
+// so a visualization without shared memory still gets every stream.
+//
+// Both sides map the same bytes, so the offsets are pinned below:
+// changing the layout means bumping SHM_RING_VERSION.
+// --------------------------------------------------------------------
+
+namespace terrafirma {
+
+constexpr uint32_t SHM_RING_MAGIC = 0x47524654;  // "TFRG"
+constexpr uint32_t SHM_RING_VERSION = 1;
+
+// Same values as MUX_STREAM_*
+constexpr uint16_t SHM_STREAM_POSE = MUX_STREAM_POSE;
+constexpr uint16_t SHM_STREAM_LIDAR = MUX_STREAM_LIDAR;
+constexpr uint16_t SHM_STREAM_TELEM = MUX_STREAM_TELEM;
+constexpr uint16_t SHM_STREAM_STATE = MUX_STREAM_STATE;
+constexpr uint16_t SHM_STREAM_PAD = 0xFFFF;  // filler up to the end of the buffer
+
+struct ShmRingHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t capacity;       // record bytes after the header, power of two
+    int32_t writerPid;       // lets the reader notice a dead emulator
+    std::atomic<int32_t> readerPid;  // 0 = no reader attached
+    alignas(64) std::atomic<uint64_t> writePos;
+    alignas(64) std::atomic<uint64_t> readPos;
+    alignas(64) char data[1];  // 'capacity' bytes
+};
+
+struct ShmRecordHeader {
+    uint32_t size;
+    uint16_t stream;
+    uint16_t reserved;
+};
+
+static_assert(std::atomic<int32_t>::is_always_lock_free && std::atomic<uint64_t>::is_always_lock_free,
+              "ring fields shared between processes must be lock-free");
+static_assert(sizeof(std::atomic<int32_t>) == 4 && sizeof(std::atomic<uint64_t>) == 8,
+              "atomics must have the size of the plain integers");
+static_assert(offsetof(ShmRingHeader, capacity) == 8 && offsetof(ShmRingHeader, writerPid) == 16 &&
+              offsetof(ShmRingHeader, readerPid) == 20 && offsetof(ShmRingHeader, writePos) == 64 &&
+              offsetof(ShmRingHeader, readPos) == 128 && offsetof(ShmRingHeader, data) == 192,
+              "ShmRingHeader layout changed: bump SHM_RING_VERSION");
+static_assert(sizeof(ShmRecordHeader) == 8 && offsetof(ShmRecordHeader, stream) == 4,
+              "record header must be 8 bytes");
+
+// Shared memory object name for a rover, e.g. "/terrafirma_rover3"
+inline std::string shmRingName(int roverId)
+{
+    return "/terrafirma_rover" + std::to_string(roverId);
+}
+
+inline size_t shmRingMappedSize(uint64_t capacity)
+{
+    return offsetof(ShmRingHeader, data) + capacity;
+}
+
+// True if a record header at 'offset' and its 'size' payload bytes lie
+// inside the buffer. Readers check this before touching a payload, so a
+// corrupt ring can't send them past the mapping.
+inline bool shmRecordFits(uint64_t capacity, uint64_t offset, uint32_t size)
+{
+    return offset + sizeof(ShmRecordHeader) <= capacity &&
+           size <= capacity - offset - sizeof(ShmRecordHeader);
+}
+
+} // namespace terrafirma
+
+#endif // TERRAFIRMA_SHM_RING_LAYOUT_H
@@ -1,18 +1,12 @@
 #!/bin/bash
 
-# Check if --no-noise is passed
-NOISE_FLAG=""
-if [[ "$1" == "--no-noise" ]]; then
-    NOISE_FLAG="--no-noise"
-fi
+# Any arguments (e.g. --no-noise, --binary) are passed to the emulator
 
-# Start rover emulator instances for IDs 1-5
+# Start one emulator process driving rovers 1-5
 PIDS=()
 
-for ID in {1..5}; do
-    ./rover_emulator "$ID" $NOISE_FLAG &  # Append the noise flag if specified
-    PIDS+=($!)  # Store PID
-done
+./rover_emulator 1-5 "$@" &  # Append the emulator flags if specified
+PIDS+=($!)  # Store PID
 
 # Function to kill all child processes on script exit
 cleanup() {
@@ -11,55 +11,18 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+// Packet structures, wire constants and ports, shared with the emulator
+#include "rover_protocol.h"
+
 namespace terrafirma {
 
 // Number of rovers
 constexpr int NUM_ROVERS = 5;
 
-// Network ports
-constexpr int POSE_PORT_BASE = 9000;
-constexpr int LIDAR_PORT_BASE = 10000;
-constexpr int TELEM_PORT_BASE = 11000;
-constexpr int CMD_PORT_BASE = 8000;
-
-// LiDAR constants
-constexpr size_t MAX_LIDAR_POINTS_PER_PACKET = 100;
-
-// Packet structures (must match emulator)
-#pragma pack(push, 1)
-struct PosePacket {
-    double timestamp;
-    float posX;
-    float posY;
-    float posZ;
-    float rotXdeg;
-    float rotYdeg;
-    float rotZdeg;
-};
-
-struct LidarPacketHeader {
-    double timestamp;
-    uint32_t chunkIndex;
-    uint32_t totalChunks;
-    uint32_t pointsInThisChunk;
-};
-
-struct LidarPoint {
-    float x;
-    float y;
-    float z;
-};
-
-struct LidarPacket {
-    LidarPacketHeader header;
-    LidarPoint points[MAX_LIDAR_POINTS_PER_PACKET];
-};
-
-struct VehicleTelem {
-    double timestamp;
-    uint8_t buttonStates;
-};
-#pragma pack(pop)
+// Default receive buffer: the largest UDP payload, so no datagram is
+// ever truncated. The emulator sizes LiDAR chunks to the path MTU
+// (--chunk-bytes), which on loopback means up to 65507 bytes.
+constexpr size_t MAX_DATAGRAM_SIZE = 65536;
 
 // Rover state
 struct RoverState {
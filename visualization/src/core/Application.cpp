@@ -10,7 +10,8 @@ namespace terrafirma {
 
 static Application* g_app = nullptr;
 
-Application::Application() {
+Application::Application(const NetworkConfig& networkConfig)
+    : m_networkConfig(networkConfig) {
     g_app = this;
 }
 
@@ -63,7 +64,7 @@ bool Application::init() {
 
     // Initialize components
     m_dataManager = std::make_unique<DataManager>();
-    m_networkReceiver = std::make_unique<UDPReceiver>(m_dataManager.get());
+    m_networkReceiver = std::make_unique<UDPReceiver>(m_dataManager.get(), m_networkConfig);
     // Coordinate system: X=horizontal, Y=height (UP), Z=horizontal (forward)
     // Data: X=50-500, Y=30-80 (height), Z=100-400
     // Position camera above (high Y) and behind (low Z) looking forward (+Z)
@@ -95,9 +96,10 @@ bool Application::init() {
         return false;
     }
 
-    // Start network thread
+    // Start map integration, then the receive workers feeding it
     m_running = true;
-    m_networkThread = std::thread(&Application::networkThreadFunc, this);
+    m_dataManager->startIntegration();
+    m_networkReceiver->start();
 
     std::cout << "Application initialized successfully\n";
     return true;
@@ -119,9 +121,11 @@ void Application::run() {
 
 void Application::shutdown() {
     m_running = false;
-    
-    if (m_networkThread.joinable()) {
-        m_networkThread.join();
+    if (m_networkReceiver) {
+        m_networkReceiver->stop();
+    }
+    if (m_dataManager) {
+        m_dataManager->stopIntegration();
     }
 
     m_uiManager.reset();
@@ -655,13 +659,6 @@ void Application::render() {
     m_uiManager->end();
 }
 
-void Application::networkThreadFunc() {
-    while (m_running) {
-        m_networkReceiver->update();
-        std::this_thread::sleep_for(std::chrono::milliseconds(1));
-    }
-}
-
 // Callbacks
 void Application::keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods) {
     (void)scancode;
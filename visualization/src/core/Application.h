@@ -23,7 +23,7 @@ namespace terrafirma {
 
 class Application {
 public:
-    Application();
+    explicit Application(const NetworkConfig& networkConfig = NetworkConfig());
     ~Application();
 
     bool init();
@@ -41,7 +41,6 @@ private:
     void processInput();
     void update(float deltaTime);
     void render();
-    void networkThreadFunc();
     void handleCircleDrawing(double mouseX, double mouseY, bool pressed, bool released);
     void handleRTSClick(double mouseX, double mouseY);
     void updatePathMovement(int roverIndex, float deltaTime);
@@ -55,6 +54,7 @@ private:
     int m_windowedWidth = 1280, m_windowedHeight = 720;
 
     Timer m_timer;
+    NetworkConfig m_networkConfig;
     std::unique_ptr<DataManager> m_dataManager;
     std::unique_ptr<UDPReceiver> m_networkReceiver;
     std::unique_ptr<Renderer> m_renderer;
@@ -63,8 +63,7 @@ private:
     std::unique_ptr<CircleRenderer> m_circleRenderer;
     std::unique_ptr<TerrainOperationManager> m_opManager;
 
-    // Network thread
-    std::thread m_networkThread;
+    // Main loop; the network receives on UDPReceiver's own workers
     std::atomic<bool> m_running{false};
 
     // Input state
@@ -32,6 +32,30 @@ void TerrainGrid::addPoint(const glm::vec3& point) {
     m_pendingUpdate = true; // Mark for update but don't set dirty yet
 }
 
+void TerrainGrid::merge(const TerrainDelta& delta) {
+    if (delta.empty()) return;
+    
+    bool wasEmpty = m_cells.empty();
+    for (const auto& cell : delta.cells) {
+        auto it = m_cells.find(cell.first);
+        if (it == m_cells.end()) {
+            m_cells.emplace(cell.first, cell.second);
+        } else {
+            it->second = std::max(it->second, cell.second);
+        }
+    }
+    
+    if (wasEmpty) {
+        m_minHeight = delta.minHeight;
+        m_maxHeight = delta.maxHeight;
+    } else {
+        m_minHeight = std::min(m_minHeight, delta.minHeight);
+        m_maxHeight = std::max(m_maxHeight, delta.maxHeight);
+    }
+    
+    m_pendingUpdate = true; // Mark for update but don't set dirty yet
+}
+
 void TerrainGrid::checkDirty() {
     if (m_pendingUpdate) {
         double now = glfwGetTime();
@@ -51,6 +75,26 @@ void TerrainGrid::clear() {
     m_pendingUpdate = false;
 }
 
+// TerrainDelta implementation
+void TerrainDelta::addPoint(const LidarPoint& point, float cellSize) {
+    // Same cells as TerrainGrid::addPoint
+    int cx = static_cast<int>(std::floor(point.x / cellSize));
+    int cz = static_cast<int>(std::floor(point.z / cellSize));
+    
+    if (cells.empty()) {
+        minHeight = point.y;
+        maxHeight = point.y;
+    } else {
+        minHeight = std::min(minHeight, point.y);
+        maxHeight = std::max(maxHeight, point.y);
+    }
+    
+    auto inserted = cells.emplace(std::make_pair(cx, cz), point.y);
+    if (!inserted.second) {
+        inserted.first->second = std::max(inserted.first->second, point.y);
+    }
+}
+
 // DataManager implementation
 DataManager::DataManager()
     : m_rovers{{RoverData(1), RoverData(2), RoverData(3), RoverData(4), RoverData(5)}},
@@ -58,6 +102,10 @@ DataManager::DataManager()
 {
 }
 
+DataManager::~DataManager() {
+    stopIntegration();
+}
+
 void DataManager::updateRoverPose(int roverId, const PosePacket& pose) {
     if (roverId < 1 || roverId > NUM_ROVERS) return;
     
@@ -77,26 +125,117 @@ void DataManager::updateRoverTelemetry(int roverId, const VehicleTelem& telem) {
     m_rovers[roverId - 1].updateTelemetry(telem);
 }
 
-void DataManager::update(float deltaTime) {
+void DataManager::updateRoverState(int roverId, const StatePacket& state) {
+    if (roverId < 1 || roverId > NUM_ROVERS) return;
+    int index = roverId - 1;
+
+    PosePacket pose;
+    pose.timestamp = state.timestamp;
+    pose.posX = state.posX;
+    pose.posY = state.posY;
+    pose.posZ = state.posZ;
+    pose.rotXdeg = state.rotXdeg;
+    pose.rotYdeg = state.rotYdeg;
+    pose.rotZdeg = state.rotZdeg;
+    pose.sequence = state.sequence;
+
+    VehicleTelem telem;
+    telem.timestamp = state.timestamp;
+    telem.buttonStates = state.buttonStates;
+    telem.sequence = state.sequence;
+
+    // Same rule as updateRoverPose: an operation owns the position
+    bool applyPose = (state.flags & STATE_FLAG_POSE) && !m_roverControlled[index].load();
+
     std::lock_guard<std::mutex> lock(m_mutex);
-    for (int i = 0; i < NUM_ROVERS; i++) {
-        // Only interpolate if rover is NOT being controlled by an operation
-        if (!m_roverControlled[i].load()) {
-            m_rovers[i].interpolate(deltaTime);
+    if (applyPose) {
+        m_rovers[index].updatePose(pose);
+    }
+    m_rovers[index].updateTelemetry(telem);
+}
+
+void DataManager::update(float deltaTime) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (int i = 0; i < NUM_ROVERS; i++) {
+            // Only interpolate if rover is NOT being controlled by an operation
+            if (!m_roverControlled[i].load()) {
+                m_rovers[i].interpolate(deltaTime);
+            }
+        }
+    }
+    
+    // Point clouds handle their own sync in the renderer. Terrain heights
+    // are taken over if the integration thread isn't adding to them right
+    // now, otherwise next frame.
+    {
+        std::unique_lock<std::mutex> lock(m_deltaMutex, std::try_to_lock);
+        if (lock.owns_lock() && !m_terrainDelta.empty()) {
+            std::swap(m_terrainDelta, m_mergeDelta);
         }
     }
-    // Point clouds handle their own sync in the renderer
+    if (!m_mergeDelta.empty()) {
+        m_terrain.merge(m_mergeDelta);
+        m_mergeDelta.clear();
+    }
     m_terrain.checkDirty();
 }
 
-void DataManager::addPointCloud(int roverId, const std::vector<LidarPoint>& points) {
-    if (roverId < 1 || roverId > NUM_ROVERS) return;
-    std::lock_guard<std::mutex> lock(m_mutex);
-    m_pointClouds[roverId - 1].addPoints(points);
+bool DataManager::addPointCloud(int roverId, std::vector<LidarPoint>& points) {
+    if (roverId < 1 || roverId > NUM_ROVERS) return false;
+    if (!m_scanQueue.push(roverId, points)) {
+        m_droppedScans++;
+        return false;
+    }
     
-    // Also add to terrain grid
-    for (const auto& p : points) {
-        m_terrain.addPoint(glm::vec3(p.x, p.y, p.z));
+    // Pairs with the fence in integrationLoop: either the integration
+    // thread sees the scan before it sleeps, or we see it asleep
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_integrationIdle.load(std::memory_order_relaxed)) {
+        std::lock_guard<std::mutex> lock(m_idleMutex);
+        m_scanReady.notify_one();
+    }
+    return true;
+}
+
+void DataManager::startIntegration() {
+    if (m_integrating.exchange(true)) return;
+    m_integrationThread = std::thread(&DataManager::integrationLoop, this);
+}
+
+void DataManager::stopIntegration() {
+    if (!m_integrating.exchange(false)) return;
+    {
+        std::lock_guard<std::mutex> lock(m_idleMutex);
+        m_scanReady.notify_one();
+    }
+    m_integrationThread.join();
+}
+
+void DataManager::integrationLoop() {
+    while (m_integrating.load()) {
+        if (const ScanQueue::Entry* scan = m_scanQueue.front()) {
+            integrate(*scan);
+            m_scanQueue.pop();
+            continue;
+        }
+        
+        std::unique_lock<std::mutex> lock(m_idleMutex);
+        m_integrationIdle.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        m_scanReady.wait(lock, [this] { return !m_integrating.load() || m_scanQueue.front(); });
+        m_integrationIdle.store(false, std::memory_order_relaxed);
+    }
+}
+
+void DataManager::integrate(const ScanQueue::Entry& scan) {
+    m_pointClouds[scan.roverId - 1].addPoints(scan.points);
+    
+    // Also add to terrain grid, by way of the delta
+    const float cellSize = m_terrain.getCellSize();
+    std::lock_guard<std::mutex> lock(m_deltaMutex);
+    for (const auto& p : scan.points) {
+        m_terrainDelta.addPoint(p, cellSize);
     }
 }
 
@@ -111,7 +250,6 @@ PointCloud& DataManager::getPointCloud(int index) {
 }
 
 TerrainGrid& DataManager::getTerrainGrid() {
-    std::lock_guard<std::mutex> lock(m_mutex);
     return m_terrain;
 }
 
@@ -3,19 +3,39 @@
 #include "common.h"
 #include "data/RoverData.h"
 #include "data/PointCloud.h"
+#include "data/ScanQueue.h"
 #include <array>
+#include <atomic>
+#include <condition_variable>
 #include <mutex>
+#include <thread>
 #include <vector>
 #include <map>
 
 namespace terrafirma {
 
+// Terrain heights gathered off the render thread, waiting to be merged
+// into the grid: the highest point per cell, plus the height range of
+// every point added
+struct TerrainDelta {
+    std::map<std::pair<int, int>, float> cells;
+    float minHeight = 0.0f;
+    float maxHeight = 0.0f;
+
+    void addPoint(const LidarPoint& point, float cellSize);
+    bool empty() const { return cells.empty(); }
+    void clear() { cells.clear(); }
+};
+
 // Simple terrain grid
 class TerrainGrid {
 public:
     TerrainGrid(float cellSize = 1.0f);
     
     void addPoint(const glm::vec3& point);
+    // Raises each of the delta's cells to its height and widens the
+    // height range, like adding the delta's points one by one
+    void merge(const TerrainDelta& delta);
     void clear();
     void checkDirty(); // Check if enough time has passed to mark as dirty
     
@@ -40,11 +60,24 @@ private:
 class DataManager {
 public:
     DataManager();
+    ~DataManager();
     
     // Thread-safe updates (call from network thread)
     void updateRoverPose(int roverId, const PosePacket& pose);
     void updateRoverTelemetry(int roverId, const VehicleTelem& telem);
-    void addPointCloud(int roverId, const std::vector<LidarPoint>& points);
+    // Pose (if flagged) and telemetry under a single lock
+    void updateRoverState(int roverId, const StatePacket& state);
+    // Queues a completed scan for the integration thread without waiting
+    // on it, swapping 'points' for a recycled buffer (see ScanQueue);
+    // false (and counted) when the queue is full
+    bool addPointCloud(int roverId, std::vector<LidarPoint>& points);
+    
+    // Integration thread: moves queued scans into the point clouds and
+    // the terrain delta. Scans queued while it isn't running wait.
+    void startIntegration();
+    void stopIntegration();
+    size_t getQueuedScans() const { return m_scanQueue.size(); }
+    uint64_t getDroppedScans() const { return m_droppedScans.load(); }
     
     // Call from render thread each frame
     void update(float deltaTime);
@@ -52,6 +85,8 @@ public:
     // Accessors (call from render thread)
     RoverState& getRover(int index);
     PointCloud& getPointCloud(int index);
+    // Only the render thread touches the grid; scans reach it through
+    // the delta merged in update()
     TerrainGrid& getTerrainGrid();
     
     size_t getTotalPointCount() const;
@@ -65,12 +100,32 @@ public:
     void setRoverControlled(int index, bool controlled);
 
 private:
+    void integrationLoop();
+    void integrate(const ScanQueue::Entry& scan);
+    
     std::array<RoverData, NUM_ROVERS> m_rovers;
     std::array<PointCloud, NUM_ROVERS> m_pointClouds;
-    TerrainGrid m_terrain;
+    TerrainGrid m_terrain;  // render thread only
     std::array<std::atomic<bool>, NUM_ROVERS> m_roverControlled{};  // True when operation controls position
     
-    mutable std::mutex m_mutex;
+    mutable std::mutex m_mutex;  // rover state
+    
+    // Network -> integration thread
+    ScanQueue m_scanQueue;
+    std::atomic<uint64_t> m_droppedScans{0};
+    std::thread m_integrationThread;
+    std::atomic<bool> m_integrating{false};
+    // Held by the integration thread only to sleep on m_scanReady; a
+    // producer takes it only to wake a sleeping integration thread
+    std::mutex m_idleMutex;
+    std::condition_variable m_scanReady;
+    std::atomic<bool> m_integrationIdle{false};
+    
+    // Integration thread -> render thread. update() only try_locks it,
+    // and takes the whole delta with a swap.
+    std::mutex m_deltaMutex;
+    TerrainDelta m_terrainDelta;
+    TerrainDelta m_mergeDelta;  // render thread only
 };
 
 } // namespace terrafirma
@@ -1,5 +1,7 @@
 #include "data/PointCloud.h"
 #include <algorithm>
+#include <cstring>
+#include <type_traits>
 
 namespace terrafirma {
 
@@ -7,16 +9,23 @@ PointCloud::PointCloud() {
     m_points.reserve(2000000); // 2 million points
 }
 
+// A LidarPoint is three floats like glm::vec3, so a scan is stored with
+// one copy of the whole buffer
+static_assert(sizeof(LidarPoint) == sizeof(glm::vec3) && std::is_trivially_copyable<glm::vec3>::value,
+              "LidarPoint must match glm::vec3");
+
 void PointCloud::addPoints(const std::vector<LidarPoint>& points) {
+    if (points.empty()) return;
     std::lock_guard<std::mutex> lock(m_mutex);
     
+    size_t first = m_points.size();
+    m_points.resize(first + points.size());
+    std::memcpy(static_cast<void*>(m_points.data() + first), points.data(), points.size() * sizeof(LidarPoint));
+    
     for (const auto& p : points) {
-        glm::vec3 point(p.x, p.y, p.z);
-        m_points.push_back(point);
-        
         // Y is height
-        m_minHeight = std::min(m_minHeight, point.y);
-        m_maxHeight = std::max(m_maxHeight, point.y);
+        m_minHeight = std::min(m_minHeight, p.y);
+        m_maxHeight = std::max(m_maxHeight, p.y);
     }
 }
 
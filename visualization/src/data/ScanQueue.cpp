@@ -0,0 +1,59 @@
+#include "data/ScanQueue.h"
+
+namespace terrafirma {
+
+// Cell i is free for the producer at write position p when its sequence
+// is p, and holds an entry for the consumer at read position p when its
+// sequence is p + 1
+ScanQueue::ScanQueue() {
+    for (size_t i = 0; i < CAPACITY; ++i) {
+        m_cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+bool ScanQueue::push(int roverId, std::vector<LidarPoint>& points) {
+    uint64_t pos = m_writePos.load(std::memory_order_relaxed);
+    Cell* cell;
+    for (;;) {
+        cell = &m_cells[pos & (CAPACITY - 1)];
+        uint64_t sequence = cell->sequence.load(std::memory_order_acquire);
+        int64_t turn = static_cast<int64_t>(sequence - pos);
+        if (turn == 0) {
+            if (m_writePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (turn < 0) {
+            return false;  // the consumer hasn't released this cell yet
+        } else {
+            pos = m_writePos.load(std::memory_order_relaxed);  // another producer took it
+        }
+    }
+
+    cell->entry.roverId = roverId;
+    cell->entry.points.swap(points);
+    cell->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+ScanQueue::Entry* ScanQueue::front() {
+    uint64_t pos = m_readPos.load(std::memory_order_relaxed);
+    Cell& cell = m_cells[pos & (CAPACITY - 1)];
+    if (cell.sequence.load(std::memory_order_acquire) != pos + 1) {
+        return nullptr;
+    }
+    return &cell.entry;
+}
+
+void ScanQueue::pop() {
+    uint64_t pos = m_readPos.load(std::memory_order_relaxed);
+    m_cells[pos & (CAPACITY - 1)].sequence.store(pos + CAPACITY, std::memory_order_release);
+    m_readPos.store(pos + 1, std::memory_order_release);
+}
+
+size_t ScanQueue::size() const {
+    uint64_t read = m_readPos.load(std::memory_order_acquire);
+    uint64_t write = m_writePos.load(std::memory_order_acquire);
+    return write > read ? static_cast<size_t>(write - read) : 0;
+}
+
+} // namespace terrafirma
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "rover_protocol.h"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace terrafirma {
+
+// Completed scans on their way from the receive workers to the map
+// integration thread (see DataManager).
+//
+// Bounded and lock-free: any number of producers, one consumer. Each
+// cell carries a sequence number that says whose turn it is, so a
+// producer claims a cell with one compare-exchange on the write
+// position and never waits for the consumer; a full queue is reported
+// instead. The consumer reads entries in place and releases them with
+// pop().
+//
+// Scans are never copied on the way: push() swaps the producer's point
+// buffer with the cell's, handing back the buffer of a scan already
+// integrated. Together with the reassembler slots, the cells form a
+// fixed pool of buffers that only circulates, so once each has held
+// the largest scan, nothing on the way from chunk to map allocates.
+class ScanQueue {
+public:
+    static constexpr size_t CAPACITY = 16;  // power of two
+
+    struct Entry {
+        int roverId = 0;
+        std::vector<LidarPoint> points;
+    };
+
+    ScanQueue();
+
+    // Producers. Moves the scan into the next free cell, leaving
+    // 'points' holding a recycled buffer (contents unspecified); false,
+    // and 'points' untouched, when the queue is full
+    bool push(int roverId, std::vector<LidarPoint>& points);
+
+    // Consumer. The oldest entry, or nullptr when the queue is empty;
+    // it stays valid until pop()
+    Entry* front();
+    void pop();
+
+    // Entries pushed and not yet popped (approximate while in use)
+    size_t size() const;
+
+private:
+    struct Cell {
+        std::atomic<uint64_t> sequence{0};
+        Entry entry;
+    };
+
+    std::array<Cell, CAPACITY> m_cells;
+    alignas(64) std::atomic<uint64_t> m_writePos{0};
+    alignas(64) std::atomic<uint64_t> m_readPos{0};
+};
+
+} // namespace terrafirma
@@ -1,12 +1,59 @@
 #include "core/Application.h"
+#include <cstdlib>
 #include <iostream>
+#include <string>
+
+int main(int argc, char** argv) {
+    terrafirma::NetworkConfig networkConfig;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--max-datagram" && i + 1 < argc) {
+            // Must be at least the emulator's --chunk-bytes
+            networkConfig.maxDatagramBytes = std::strtoul(argv[++i], nullptr, 10);
+            if (networkConfig.maxDatagramBytes < sizeof(terrafirma::LidarPacketHeader) ||
+                networkConfig.maxDatagramBytes > terrafirma::MAX_DATAGRAM_SIZE) {
+                std::cerr << "--max-datagram must be between " << sizeof(terrafirma::LidarPacketHeader)
+                          << " and " << terrafirma::MAX_DATAGRAM_SIZE << " bytes\n";
+                return 1;
+            }
+        } else if (arg == "--recv-batch" && i + 1 < argc) {
+            networkConfig.receiveBatch = std::atoi(argv[++i]);
+            if (networkConfig.receiveBatch < 1 || networkConfig.receiveBatch > 1024) {
+                std::cerr << "--recv-batch must be between 1 and 1024\n";
+                return 1;
+            }
+        } else if (arg == "--recv-workers" && i + 1 < argc) {
+            networkConfig.receiveWorkers = std::atoi(argv[++i]);
+            if (networkConfig.receiveWorkers < 1 || networkConfig.receiveWorkers > terrafirma::NUM_ROVERS) {
+                std::cerr << "--recv-workers must be between 1 and " << terrafirma::NUM_ROVERS << "\n";
+                return 1;
+            }
+        } else if (arg == "--no-shm") {
+            networkConfig.sharedMemory = false;
+        } else if (arg == "--mux") {
+            networkConfig.multiplexed = true;
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--max-datagram BYTES] [--recv-batch N] [--recv-workers N]"
+                      << " [--no-shm] [--mux]\n"
+                      << "  --max-datagram BYTES  receive buffer size (default "
+                      << terrafirma::MAX_DATAGRAM_SIZE << ")\n"
+                      << "  --recv-batch N        datagrams read per receive call (default "
+                      << terrafirma::NetworkConfig().receiveBatch << ")\n"
+                      << "  --recv-workers N      receive threads, rovers dealt out among them (default "
+                      << terrafirma::NetworkConfig().receiveWorkers << ")\n"
+                      << "  --no-shm              ignore the emulator's shared memory, UDP only\n"
+                      << "  --mux                 receive every rover on port " << terrafirma::INGEST_PORT
+                      << " (emulator --mux)\n";
+            return 1;
+        }
+    }
 
-int main() {
     std::cout << "=================================\n";
     std::cout << " Terrafirma Rovers Command Center\n";
     std::cout << "=================================\n\n";
 
-    terrafirma::Application app;
+    terrafirma::Application app(networkConfig);
     
     if (!app.init()) {
         std::cerr << "Failed to initialize application\n";
@@ -0,0 +1,87 @@
+#include "network/LidarReassembler.h"
+#include "network/PacketParser.h"
+
+namespace terrafirma {
+
+LidarScan* LidarReassembler::addChunk(const LidarPacketHeaderView& header) {
+    const uint32_t scanId = header.scanId();
+    Slot& slot = m_slots[scanId % SLOTS];
+
+    if (!slot.inUse || slot.scan.scanId != scanId) {
+        int32_t newer = static_cast<int32_t>(scanId - slot.scan.scanId);
+        if (slot.inUse && newer < 0 && newer > -static_cast<int32_t>(LATE_LIMIT)) {
+            return nullptr;  // late chunk of a scan whose slot has moved on
+        }
+        if (slot.inUse && !slot.complete) {
+            m_incompleteScans++;
+        }
+        if (!startScan(slot, header)) {
+            slot.inUse = false;
+            m_invalidChunks++;
+            return nullptr;
+        }
+    }
+
+    // Duplicates and chunks of a finished scan are ignored
+    const uint32_t chunkIndex = header.chunkIndex();
+    if (slot.complete || chunkIndex >= slot.totalChunks) {
+        return nullptr;
+    }
+    uint64_t& word = slot.chunkMask[chunkIndex / 64];
+    const uint64_t bit = uint64_t(1) << (chunkIndex % 64);
+    if (word & bit) {
+        return nullptr;
+    }
+
+    // The chunk's points must lie inside the scan it claims to belong to
+    const uint64_t first = header.firstPoint();
+    const uint64_t count = header.pointsInThisChunk();
+    if (header.totalChunks() != slot.totalChunks || header.scanPoints() != slot.scan.points.size() ||
+        first + count > slot.scan.points.size()) {
+        m_invalidChunks++;
+        return nullptr;
+    }
+
+    word |= bit;
+    PacketParser::decodeLidarPoints(header, slot.scan.points.data() + first);
+    if (++slot.receivedChunks < slot.totalChunks) {
+        return nullptr;
+    }
+    slot.complete = true;
+    return &slot.scan;
+}
+
+// Resets 'slot' for the scan 'header' belongs to, growing its buffers
+// if this scan is the largest yet. False for a scan too large to accept.
+bool LidarReassembler::startScan(Slot& slot, const LidarPacketHeaderView& header) {
+    const uint32_t totalChunks = header.totalChunks();
+    const uint32_t scanPoints = header.scanPoints();
+    if (totalChunks == 0 || totalChunks > MAX_SCAN_POINTS || scanPoints > MAX_SCAN_POINTS) {
+        return false;
+    }
+
+    uint32_t allocations = 0;
+    const size_t words = (static_cast<size_t>(totalChunks) + 63) / 64;
+    if (slot.chunkMask.capacity() < words) {
+        allocations++;
+    }
+    slot.chunkMask.assign(words, 0);
+    if (slot.scan.points.capacity() < scanPoints) {
+        allocations++;
+    }
+    // Every point is overwritten by its chunk before the scan completes
+    slot.scan.points.resize(scanPoints);
+    m_allocations += allocations;
+
+    slot.inUse = true;
+    slot.complete = false;
+    slot.totalChunks = totalChunks;
+    slot.receivedChunks = 0;
+    slot.scan.scanId = header.scanId();
+    slot.scan.flags = header.flags();
+    slot.scan.suppressedPoints = header.suppressedPoints();
+    slot.scan.allocations = allocations;
+    return true;
+}
+
+} // namespace terrafirma
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "rover_protocol.h"
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace terrafirma {
+
+// A reassembled LiDAR scan, points in the order the sender split them
+// (whatever order the chunks arrived in)
+struct LidarScan {
+    uint32_t scanId = 0;
+    uint16_t flags = 0;             // LIDAR_FLAG_* of the scan
+    uint32_t suppressedPoints = 0;
+    uint32_t allocations = 0;       // buffers grown to reassemble it
+    std::vector<LidarPoint> points;
+};
+
+// LiDAR chunk reassembly for one rover.
+//
+// Scans go into a small ring of slots indexed by scanId % SLOTS. A slot
+// is sized for the whole scan when its first chunk arrives (scanPoints),
+// and every chunk is decoded straight to its firstPoint offset, so
+// chunks may arrive in any order. Completion is a per-chunk bitmask.
+// A scan still incomplete when its slot is needed again (SLOTS scans
+// later) is given up in O(1), without looking at the other slots.
+//
+// Slot buffers only grow: once they have seen the rover's largest scan
+// and chunk count, reassembly allocates nothing. A completed scan's
+// points may be swapped out for another buffer (see ScanQueue::push);
+// the slot then grows that one if it must.
+class LidarReassembler {
+public:
+    static constexpr uint32_t SLOTS = 8;
+    // Chunks of older scans are dropped as late; anything further back
+    // means the sender restarted its scan counter
+    static constexpr uint32_t LATE_LIMIT = 64;
+    // Scans claiming more points are rejected rather than allocated for
+    static constexpr uint32_t MAX_SCAN_POINTS = 1u << 22;
+
+    // Stores one chunk that passed PacketParser::checkLidarChunk.
+    // Returns the scan it completed, or nullptr; the scan stays valid
+    // until the next call, and its points are the caller's to take.
+    LidarScan* addChunk(const LidarPacketHeaderView& header);
+
+    // Scans given up with chunks missing
+    uint64_t getIncompleteScans() const { return m_incompleteScans; }
+    // Chunks whose header doesn't fit their scan (wrong range or counts)
+    uint64_t getInvalidChunks() const { return m_invalidChunks; }
+    // Times a slot buffer had to grow; flat in steady state
+    uint64_t getAllocations() const { return m_allocations; }
+
+private:
+    struct Slot {
+        bool inUse = false;
+        bool complete = false;
+        uint32_t totalChunks = 0;
+        uint32_t receivedChunks = 0;
+        std::vector<uint64_t> chunkMask;  // bit per chunk received
+        LidarScan scan;
+    };
+
+    bool startScan(Slot& slot, const LidarPacketHeaderView& header);
+
+    std::array<Slot, SLOTS> m_slots;
+    uint64_t m_incompleteScans = 0;
+    uint64_t m_invalidChunks = 0;
+    uint64_t m_allocations = 0;
+};
+
+} // namespace terrafirma
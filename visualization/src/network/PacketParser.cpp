@@ -1,25 +1,78 @@
 #include "network/PacketParser.h"
 #include <cstring>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 namespace terrafirma {
 
-bool PacketParser::parsePose(const char* data, size_t size, PosePacket& out) {
-    if (size < sizeof(PosePacket)) return false;
-    std::memcpy(&out, data, sizeof(PosePacket));
-    return true;
+namespace {
+
+// out[i] = origin + q[i] * resolution over 'count' packed x,y,z int16
+// points in wire order at 'q' (any alignment)
+void dequantize(const char* q, size_t count, const LidarPacketHeaderView& header, float* out) {
+    const float origin[3] = { header.originX(), header.originY(), header.originZ() };
+    const float resolution = header.resolution();
+    const size_t values = count * 3;
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    // 24 values (8 points) per iteration. The x,y,z origin pattern
+    // repeats every 12 floats, i.e. every three 4-wide vectors.
+    const __m128 scale = _mm_set1_ps(resolution);
+    const __m128 o0 = _mm_setr_ps(origin[0], origin[1], origin[2], origin[0]);
+    const __m128 o1 = _mm_setr_ps(origin[1], origin[2], origin[0], origin[1]);
+    const __m128 o2 = _mm_setr_ps(origin[2], origin[0], origin[1], origin[2]);
+    const __m128 originPattern[3] = { o0, o1, o2 };
+
+    for (; i + 24 <= values; i += 24) {
+        for (int part = 0; part < 3; ++part) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(q + (i + part * 8) * sizeof(int16_t)));
+            // Sign-extend int16 -> int32: duplicate each lane, then shift down
+            __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+            __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+            size_t base = i + part * 8;
+            _mm_storeu_ps(out + base, _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(lo), scale),
+                                                 originPattern[(part * 8) % 3]));
+            _mm_storeu_ps(out + base + 4, _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(hi), scale),
+                                                     originPattern[(part * 8 + 4) % 3]));
+        }
+    }
+#endif
+
+    for (; i < values; ++i) {
+        out[i] = origin[i % 3] + static_cast<float>(wire::load<int16_t>(q + i * sizeof(int16_t))) * resolution;
+    }
 }
 
-bool PacketParser::parseLidarHeader(const char* data, size_t size, LidarPacketHeader& out) {
-    if (size < sizeof(LidarPacketHeader)) return false;
-    std::memcpy(&out, data, sizeof(LidarPacketHeader));
-    return true;
+} // namespace
+
+bool PacketParser::checkLidarChunk(const LidarPacketHeaderView& header, size_t size) {
+    if (size < LidarPacketHeaderView::SIZE) return false;
+    if (header.magic() != LIDAR_MAGIC || header.version() != LIDAR_PROTOCOL_VERSION) return false;
+
+    size_t pointSize = lidarPointSize(header.encoding());
+    if (pointSize == 0) return false;
+    return header.pointsInThisChunk() <= (size - LidarPacketHeaderView::SIZE) / pointSize;
 }
 
-bool PacketParser::parseTelemetry(const char* data, size_t size, VehicleTelem& out) {
-    if (size < sizeof(VehicleTelem)) return false;
-    std::memcpy(&out, data, sizeof(VehicleTelem));
-    return true;
+void PacketParser::decodeLidarPoints(const LidarPacketHeaderView& header, LidarPoint* out) {
+    const char* payload = header.data() + LidarPacketHeaderView::SIZE;
+    const size_t count = header.pointsInThisChunk();
+    static_assert(sizeof(LidarPoint) == 3 * sizeof(float), "LidarPoint must be 3 packed floats");
+    static_assert(sizeof(LidarPointQ16) == 3 * sizeof(int16_t), "LidarPointQ16 must be 3 packed int16");
+
+    if (header.encoding() == LIDAR_ENCODING_INT16) {
+        dequantize(payload, count, header, reinterpret_cast<float*>(out));
+    } else if (HOST_IS_LITTLE_ENDIAN) {
+        // Wire order is host order: the points copy straight out
+        std::memcpy(out, payload, count * sizeof(LidarPoint));
+    } else {
+        for (size_t i = 0; i < count; ++i) {
+            out[i] = LidarPointView(payload + i * sizeof(LidarPoint)).read();
+        }
+    }
 }
 
 } // namespace terrafirma
-
@@ -1,15 +1,24 @@
 #pragma once
 
-#include "common.h"
+#include "rover_protocol.h"
+#include <cstddef>
 
 namespace terrafirma {
 
+// LiDAR chunk validation and point decoding. Headers are read in place
+// through LidarPacketHeaderView (see protocol/rover_protocol.h); the
+// fixed-size packets need no parsing beyond their views.
 class PacketParser {
 public:
-    static bool parsePose(const char* data, size_t size, PosePacket& out);
-    static bool parseLidarHeader(const char* data, size_t size, LidarPacketHeader& out);
-    static bool parseTelemetry(const char* data, size_t size, VehicleTelem& out);
+    // Checks magic, version and encoding, and that a datagram of 'size'
+    // bytes holds all pointsInThisChunk points. On success the points
+    // start at header.data() + LidarPacketHeaderView::SIZE.
+    static bool checkLidarChunk(const LidarPacketHeaderView& header, size_t size);
+
+    // Writes the chunk's pointsInThisChunk points to 'out', dequantizing
+    // int16 chunks (SSE2 where available). The chunk must have passed
+    // checkLidarChunk.
+    static void decodeLidarPoints(const LidarPacketHeaderView& header, LidarPoint* out);
 };
 
 } // namespace terrafirma
-
@@ -0,0 +1,73 @@
+#include "network/SequenceTracker.h"
+
+namespace terrafirma {
+
+void SequenceTracker::record(uint32_t sequence) {
+    m_received++;
+    int32_t ahead = static_cast<int32_t>(sequence - m_highest);
+
+    // Far behind: a straggler, or the sender restarted from a lower
+    // number. Two far-behind datagrams in a row that continue each other
+    // mean a restart.
+    bool restarted = false;
+    if (m_started && ahead <= -WINDOW) {
+        uint32_t step = sequence - m_restartCandidate;
+        restarted = m_pendingRestart && step > 0 && step <= static_cast<uint32_t>(WINDOW);
+        if (!restarted) {
+            m_pendingRestart = true;
+            m_restartCandidate = sequence;
+            m_candidateTookLoss = m_lost > 0;
+            m_reordered++;
+            if (m_candidateTookLoss) m_lost--;
+            return;
+        }
+        // The candidate started the new run: undo counting it as a
+        // straggler and track from it, so this datagram is handled as
+        // the next one after it
+        m_reordered--;
+        if (m_candidateTookLoss) m_lost++;
+        m_highest = m_restartCandidate;
+        m_window = 1;
+        ahead = static_cast<int32_t>(step);
+    }
+    m_pendingRestart = false;
+
+    if (!m_started || ahead > RESTART_GAP) {
+        m_started = true;
+        m_highest = sequence;
+        m_window = 1;
+        return;
+    }
+
+    if (ahead > 0) {
+        // Newest so far; everything skipped is lost until it turns up
+        m_lost += static_cast<uint64_t>(ahead - 1);
+        m_window = (ahead >= WINDOW) ? 0 : (m_window << ahead);
+        m_window |= 1;
+        m_highest = sequence;
+        return;
+    }
+
+    int32_t age = -ahead;
+    uint64_t bit = uint64_t(1) << age;
+    if (m_window & bit) {
+        m_duplicates++;
+    } else {
+        m_window |= bit;
+        m_reordered++;
+        if (m_lost > 0) m_lost--;  // may predate tracking
+    }
+}
+
+double SequenceTracker::getLossRate() const {
+    uint64_t received = m_received - m_duplicates;
+    uint64_t sent = received + m_lost;
+    return sent > 0 ? static_cast<double>(m_lost) / sent : 0.0;
+}
+
+double SequenceTracker::getReorderRate() const {
+    uint64_t received = m_received - m_duplicates;
+    return received > 0 ? static_cast<double>(m_reordered) / received : 0.0;
+}
+
+} // namespace terrafirma
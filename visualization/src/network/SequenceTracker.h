@@ -0,0 +1,51 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace terrafirma {
+
+// Loss / reorder / duplicate accounting for one sequenced stream.
+//
+// Keeps the highest sequence seen plus a 64-bit bitmap of the ones just
+// below it. A gap counts as lost until the missing datagram shows up,
+// then it counts as reordered instead; a sequence already in the bitmap
+// is a duplicate. A datagram more than WINDOW behind the newest counts
+// as reordered, unless the next one continues from it: then the sender
+// restarted, that first datagram is taken back out of the reordered
+// count, and tracking starts over from it without counting losses from
+// before. A jump of more than RESTART_GAP ahead starts over too.
+//
+// record() is called from the network thread; the getters may be
+// called from any thread.
+class SequenceTracker {
+public:
+    void record(uint32_t sequence);
+
+    uint64_t getReceived() const { return m_received; }
+    uint64_t getLost() const { return m_lost; }
+    uint64_t getReordered() const { return m_reordered; }
+    uint64_t getDuplicates() const { return m_duplicates; }
+
+    // Fractions of the datagrams the sender sent since tracking started
+    double getLossRate() const;
+    double getReorderRate() const;
+
+    static constexpr int32_t WINDOW = 64;
+    static constexpr int32_t RESTART_GAP = 1 << 16;
+
+private:
+    bool m_started = false;
+    uint32_t m_highest = 0;
+    uint64_t m_window = 0;  // bit n: m_highest - n was received (n < WINDOW)
+    bool m_pendingRestart = false;
+    uint32_t m_restartCandidate = 0;  // last far-behind sequence
+    bool m_candidateTookLoss = false; // counting it as reordered cancelled a loss
+
+    std::atomic<uint64_t> m_received{0};    // including duplicates
+    std::atomic<uint64_t> m_lost{0};
+    std::atomic<uint64_t> m_reordered{0};
+    std::atomic<uint64_t> m_duplicates{0};
+};
+
+} // namespace terrafirma
@@ -0,0 +1,69 @@
+#include "network/ShmRing.h"
+#include <cerrno>
+#include <csignal>
+#include <string>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace terrafirma {
+
+ShmRingReader::~ShmRingReader() {
+    close();
+}
+
+bool ShmRingReader::open(int roverId) {
+    close();
+
+    int fd = shm_open(shmRingName(roverId).c_str(), O_RDWR, 0);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat info;
+    void* mapping = MAP_FAILED;
+    if (fstat(fd, &info) == 0 && static_cast<size_t>(info.st_size) > offsetof(ShmRingHeader, data)) {
+        mapping = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        return false;
+    }
+
+    m_ring = static_cast<ShmRingHeader*>(mapping);
+    m_size = static_cast<size_t>(info.st_size);
+    uint64_t capacity = m_ring->capacity;
+    if (m_ring->magic != SHM_RING_MAGIC || m_ring->version != SHM_RING_VERSION ||
+        shmRingMappedSize(capacity) != m_size || (capacity & (capacity - 1)) != 0) {
+        close();
+        return false;
+    }
+
+    // Left behind by an emulator that was killed: its name stays until
+    // the next emulator replaces it
+    if (!writerAlive()) {
+        close();
+        return false;
+    }
+
+    m_ring->readPos.store(m_ring->writePos.load(std::memory_order_acquire), std::memory_order_release);
+    m_ring->readerPid.store(static_cast<int32_t>(getpid()), std::memory_order_release);
+    return true;
+}
+
+void ShmRingReader::close() {
+    if (!m_ring) return;
+    int32_t self = static_cast<int32_t>(getpid());
+    m_ring->readerPid.compare_exchange_strong(self, 0);
+    munmap(m_ring, m_size);
+    m_ring = nullptr;
+    m_size = 0;
+}
+
+bool ShmRingReader::writerAlive() const {
+    if (!m_ring) return false;
+    return kill(m_ring->writerPid, 0) == 0 || errno == EPERM;
+}
+
+} // namespace terrafirma
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "shm_ring_layout.h"
+
+namespace terrafirma {
+
+// Consumer side of one rover's shared-memory ring (emulator --shm; the
+// layout is in protocol/shm_ring_layout.h). Records are handed out in
+// place, so the only copy is the one into the handler's own structures.
+class ShmRingReader {
+public:
+    ~ShmRingReader();
+
+    // Attaches to the rover's ring if the emulator has created one, and
+    // skips whatever was queued before. Publishes our PID so the
+    // emulator switches that rover from UDP to the ring.
+    bool open(int roverId);
+    void close();
+    bool isOpen() const { return m_ring != nullptr; }
+
+    // False once the emulator that created the ring has exited (then
+    // open() refuses the ring too)
+    bool writerAlive() const;
+
+    // Calls handler(stream, payload, size) for every pending record and
+    // returns how many there were. A record that doesn't fit the buffer
+    // means the ring is corrupt: everything pending is skipped.
+    template <typename Handler>
+    size_t poll(Handler&& handler) {
+        const uint64_t capacity = m_ring->capacity;
+        uint64_t read = m_ring->readPos.load(std::memory_order_relaxed);
+        uint64_t write = m_ring->writePos.load(std::memory_order_acquire);
+        size_t records = 0;
+        while (read < write) {
+            const uint64_t offset = read & (capacity - 1);
+            ShmRecordHeader record;
+            if (!shmRecordFits(capacity, offset, 0)) {
+                read = write;
+                break;
+            }
+            const char* at = m_ring->data + offset;
+            std::memcpy(&record, at, sizeof(record));
+            if (!shmRecordFits(capacity, offset, record.size)) {
+                read = write;
+                break;
+            }
+            if (record.stream != SHM_STREAM_PAD) {
+                handler(record.stream, at + sizeof(record), static_cast<size_t>(record.size));
+                ++records;
+            }
+            read += (sizeof(ShmRecordHeader) + record.size + 7) & ~uint64_t(7);
+        }
+        // Only now may the emulator reuse the space
+        m_ring->readPos.store(read, std::memory_order_release);
+        return records;
+    }
+
+private:
+    ShmRingHeader* m_ring = nullptr;
+    size_t m_size = 0;
+};
+
+} // namespace terrafirma
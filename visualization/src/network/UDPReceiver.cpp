@@ -7,14 +7,38 @@
 #include <arpa/inet.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <algorithm>
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <linux/filter.h>
+#endif
 
 namespace terrafirma {
 
-UDPReceiver::UDPReceiver(DataManager* dataManager)
-    : m_dataManager(dataManager) {
+// Room for the SO_RXQ_OVFL drop count attached to a datagram
+static constexpr size_t CONTROL_SPACE = CMSG_SPACE(sizeof(uint32_t));
+
+UDPReceiver::UDPReceiver(DataManager* dataManager, const NetworkConfig& config)
+    : m_dataManager(dataManager), m_slotSize(config.maxDatagramBytes),
+      m_batchSize(std::max(config.receiveBatch, 1)),
+      m_multiplexed(config.multiplexed), m_sharedMemory(config.sharedMemory) {
     m_poseSockets.fill(-1);
     m_lidarSockets.fill(-1);
     m_telemSockets.fill(-1);
+
+    const int workers = std::min(std::max(config.receiveWorkers, 1), NUM_ROVERS);
+    for (int k = 0; k < workers; k++) {
+        auto w = std::make_unique<Worker>();
+        w->index = k;
+        w->recvBuffer.resize(m_slotSize * m_batchSize);
+        w->batchLengths.resize(m_batchSize);
+        w->batchIov.resize(m_batchSize);
+        w->batchControl.resize(CONTROL_SPACE * m_batchSize);
+#ifdef __linux__
+        w->batchMsgs.resize(m_batchSize);
+#endif
+        m_workers.push_back(std::move(w));
+    }
 }
 
 UDPReceiver::~UDPReceiver() {
@@ -29,33 +53,134 @@ bool UDPReceiver::init() {
         return false;
     }
 
+    if (m_multiplexed && !initMultiplexed()) {
+        return false;
+    }
+    for (auto& w : m_workers) {
+        if (!initWorker(*w)) {
+            return false;
+        }
+    }
+    if (m_multiplexed) {
+        m_initialized = true;
+        std::cout << "Network receiver initialized (multiplexed on port " << INGEST_PORT << ", "
+                  << m_workers.size() << " worker" << (m_workers.size() > 1 ? "s" : "") << ")\n";
+        return true;
+    }
+
     // Create receiving sockets for each rover
     for (int i = 0; i < NUM_ROVERS; i++) {
-        int roverId = i + 1;
-        
-        if (!createSocket(m_poseSockets[i], POSE_PORT_BASE + roverId)) {
-            std::cerr << "Failed to create pose socket for rover " << roverId << "\n";
+        if (!initRoverSockets(i)) {
             return false;
         }
-        
-        if (!createSocket(m_lidarSockets[i], LIDAR_PORT_BASE + roverId)) {
-            std::cerr << "Failed to create lidar socket for rover " << roverId << "\n";
+    }
+
+    m_initialized = true;
+    std::cout << "Network receiver initialized (" << m_workers.size() << " worker"
+              << (m_workers.size() > 1 ? "s" : "") << ")\n";
+    return true;
+}
+
+bool UDPReceiver::initWorker(Worker& w) {
+    if (pipe(w.wakePipe) < 0) {
+        std::cerr << "Failed to create wake-up pipe\n";
+        return false;
+    }
+    setNonBlocking(w.wakePipe[0]);
+    setNonBlocking(w.wakePipe[1]);
+#ifdef __linux__
+    w.epoll = epoll_create1(0);
+    if (w.epoll < 0) {
+        std::cerr << "Failed to create epoll set: " << strerror(errno) << "\n";
+        return false;
+    }
+#endif
+    w.ratesStart = std::chrono::steady_clock::now();
+    if (w.ingestSocket >= 0 && !watchSocket(w, w.ingestSocket, SOCKET_TAG_INGEST)) {
+        return false;
+    }
+    return watchSocket(w, w.wakePipe[0], SOCKET_TAG_WAKE);
+}
+
+// One socket per worker, all bound to INGEST_PORT with SO_REUSEPORT.
+// The kernel would spread them by flow hash, so a rover's datagrams
+// could land on any worker; a small socket filter steers each datagram
+// to the socket of the worker that owns its rover instead. Where that
+// isn't available only one worker receives.
+bool UDPReceiver::initMultiplexed() {
+    for (size_t k = 0; k < m_workers.size(); k++) {
+        Worker& w = *m_workers[k];
+        if (!createSocket(w.ingestSocket, INGEST_PORT)) {
+            std::cerr << "Failed to create ingest socket\n";
             return false;
         }
-        
-        if (!createSocket(m_telemSockets[i], TELEM_PORT_BASE + roverId)) {
-            std::cerr << "Failed to create telemetry socket for rover " << roverId << "\n";
-            return false;
+        // Every rover's LiDAR lands in these queues; ask for room for a
+        // few scans each (the kernel caps this at net.core.rmem_max)
+        int bufferBytes = 8 << 20;
+        setsockopt(w.ingestSocket, SOL_SOCKET, SO_RCVBUF, &bufferBytes, sizeof(bufferBytes));
+        setNonBlocking(w.ingestSocket);
+
+        // Attached before the other sockets join the group, so no
+        // datagram is spread by hash in between
+        if (k == 0 && m_workers.size() > 1 && !steerMultiplexed()) {
+            std::cerr << "Can't steer multiplexed datagrams by rover; receiving with one worker\n";
+            m_workers.resize(1);
         }
+    }
+    return true;
+}
 
-        setNonBlocking(m_poseSockets[i]);
-        setNonBlocking(m_lidarSockets[i]);
-        setNonBlocking(m_telemSockets[i]);
+// Classic BPF run by the kernel to pick a socket of the INGEST_PORT
+// group, i.e. a worker, for each datagram: the low byte of the
+// MuxHeader's little-endian roverId, minus one, modulo the worker
+// count. That is getWorker() of the rover; sockets join the group in
+// worker order.
+bool UDPReceiver::steerMultiplexed() {
+#if defined(__linux__) && defined(SO_ATTACH_REUSEPORT_CBPF)
+    const uint32_t roverIdOffset = 4;
+    sock_filter code[] = {
+        BPF_STMT(BPF_LD | BPF_B | BPF_ABS, roverIdOffset),
+        BPF_STMT(BPF_ALU | BPF_SUB | BPF_K, 1),
+        BPF_STMT(BPF_ALU | BPF_MOD | BPF_K, static_cast<uint32_t>(m_workers.size())),
+        BPF_STMT(BPF_RET | BPF_A, 0),
+    };
+    static_assert(offsetof(MuxHeader, roverId) == 4, "filter reads the rover ID at offset 4");
+    sock_fprog program;
+    program.len = static_cast<unsigned short>(sizeof(code) / sizeof(code[0]));
+    program.filter = code;
+    return setsockopt(m_workers[0]->ingestSocket, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF,
+                      &program, sizeof(program)) == 0;
+#else
+    return false;
+#endif
+}
+
+bool UDPReceiver::initRoverSockets(int i) {
+    int roverId = i + 1;
+
+    if (!createSocket(m_poseSockets[i], POSE_PORT_BASE + roverId)) {
+        std::cerr << "Failed to create pose socket for rover " << roverId << "\n";
+        return false;
     }
 
-    m_initialized = true;
-    std::cout << "Network receiver initialized\n";
-    return true;
+    if (!createSocket(m_lidarSockets[i], LIDAR_PORT_BASE + roverId)) {
+        std::cerr << "Failed to create lidar socket for rover " << roverId << "\n";
+        return false;
+    }
+
+    if (!createSocket(m_telemSockets[i], TELEM_PORT_BASE + roverId)) {
+        std::cerr << "Failed to create telemetry socket for rover " << roverId << "\n";
+        return false;
+    }
+
+    setNonBlocking(m_poseSockets[i]);
+    setNonBlocking(m_lidarSockets[i]);
+    setNonBlocking(m_telemSockets[i]);
+    Worker& w = *m_workers[getWorker(i)];
+    const uint32_t tag = static_cast<uint32_t>(i) * SOCKET_TAG_STRIDE;
+    return watchSocket(w, m_poseSockets[i], tag + STREAM_POSE) &&
+           watchSocket(w, m_lidarSockets[i], tag + STREAM_LIDAR) &&
+           watchSocket(w, m_telemSockets[i], tag + STREAM_TELEM);
 }
 
 bool UDPReceiver::createSocket(int& sock, int port) {
@@ -70,6 +195,10 @@ bool UDPReceiver::createSocket(int& sock, int port) {
 #ifdef SO_REUSEPORT
     setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt));
 #endif
+#ifdef SO_RXQ_OVFL
+    // Have the kernel attach its receive-queue drop count to each datagram
+    setsockopt(sock, SOL_SOCKET, SO_RXQ_OVFL, &opt, sizeof(opt));
+#endif
 
     sockaddr_in addr;
     std::memset(&addr, 0, sizeof(addr));
@@ -92,93 +221,431 @@ void UDPReceiver::setNonBlocking(int sock) {
     fcntl(sock, F_SETFL, flags | O_NONBLOCK);
 }
 
-void UDPReceiver::update() {
-    if (!m_initialized) return;
-    receivePackets();
+// Level-triggered: a socket stays ready until drained
+bool UDPReceiver::watchSocket(Worker& w, int sock, uint32_t tag) {
+#ifdef __linux__
+    epoll_event event;
+    std::memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.u32 = tag;
+    if (epoll_ctl(w.epoll, EPOLL_CTL_ADD, sock, &event) < 0) {
+        std::cerr << "Failed to watch socket: " << strerror(errno) << "\n";
+        return false;
+    }
+#else
+    w.pollFds.push_back(pollfd{ sock, POLLIN, 0 });
+    w.pollTags.push_back(tag);
+#endif
+    return true;
 }
 
-void UDPReceiver::receivePackets() {
-    char buffer[2048];
 
-    for (int i = 0; i < NUM_ROVERS; i++) {
-        int roverId = i + 1;
-
-        // Receive pose packets - always process (emulator handles pause)
-        while (true) {
-            ssize_t n = recv(m_poseSockets[i], buffer, sizeof(buffer), 0);
-            if (n <= 0) break;
-            
-            if (n == sizeof(PosePacket)) {
-                PosePacket pose;
-                std::memcpy(&pose, buffer, sizeof(PosePacket));
-                m_dataManager->updateRoverPose(roverId, pose);
-            }
+void UDPReceiver::start() {
+    if (!m_initialized || m_running) return;
+    m_running = true;
+    for (auto& w : m_workers) {
+        w->thread = std::thread(&UDPReceiver::run, this, std::ref(*w));
+    }
+}
+
+void UDPReceiver::stop() {
+    m_running = false;
+    for (auto& w : m_workers) {
+        wake(*w);
+    }
+    for (auto& w : m_workers) {
+        if (w->thread.joinable()) {
+            w->thread.join();
+        }
+    }
+}
+
+void UDPReceiver::run(Worker& w) {
+    while (m_running) {
+        update(w);
+    }
+}
+
+void UDPReceiver::update(Worker& w) {
+    waitForDatagrams(w, waitTimeoutMs(w));
+    updateSharedMemory(w);
+    pollSharedMemory(w);
+
+    for (uint32_t tag : w.readySockets) {
+        if (tag == SOCKET_TAG_INGEST) {
+            receiveMultiplexed(w);
+        } else {
+            receiveRoverSocket(w, static_cast<int>(tag / SOCKET_TAG_STRIDE),
+                               static_cast<int>(tag % SOCKET_TAG_STRIDE));
         }
+    }
+    updateLoopRates(w);
+}
 
-        // Receive telemetry packets - always process (needed for button state updates)
-        while (true) {
-            ssize_t n = recv(m_telemSockets[i], buffer, sizeof(buffer), 0);
-            if (n <= 0) break;
-            
-            if (n == sizeof(VehicleTelem)) {
-                VehicleTelem telem;
-                std::memcpy(&telem, buffer, sizeof(VehicleTelem));
-                m_dataManager->updateRoverTelemetry(roverId, telem);
+// Sockets wake us up, shared-memory rings can't: while one of the
+// worker's rovers has its ring attached the wait is cut to 1 ms, the
+// polling interval the ring was read at before. Otherwise it only ends
+// in time for the next ring check.
+int UDPReceiver::waitTimeoutMs(const Worker& w) const {
+    if (!m_sharedMemory) {
+        return 1000;
+    }
+    for (int i = w.index; i < NUM_ROVERS; i += getWorkerCount()) {
+        if (m_rings[i].isOpen()) return 1;
+    }
+    auto untilCheck = std::chrono::duration_cast<std::chrono::milliseconds>(
+        w.nextRingCheck - std::chrono::steady_clock::now()).count();
+    return static_cast<int>(std::max<int64_t>(0, std::min<int64_t>(untilCheck + 1, 1000)));
+}
+
+// Fills readySockets with the tags of the worker's sockets that have
+// datagrams
+void UDPReceiver::waitForDatagrams(Worker& w, int timeoutMs) {
+    w.readySockets.clear();
+#ifdef __linux__
+    epoll_event events[3 * NUM_ROVERS + 2];
+    int n = epoll_wait(w.epoll, events, static_cast<int>(sizeof(events) / sizeof(events[0])), timeoutMs);
+    w.wakeups++;
+    for (int k = 0; k < n; k++) {
+        w.readySockets.push_back(events[k].data.u32);
+    }
+#else
+    int n = poll(w.pollFds.data(), static_cast<nfds_t>(w.pollFds.size()), timeoutMs);
+    w.wakeups++;
+    for (size_t k = 0; n > 0 && k < w.pollFds.size(); k++) {
+        if (w.pollFds[k].revents & (POLLIN | POLLERR)) {
+            w.readySockets.push_back(w.pollTags[k]);
+        }
+    }
+#endif
+
+    // Only stop() writes to the pipe; empty it so it doesn't stay ready
+    auto wakeTag = std::find(w.readySockets.begin(), w.readySockets.end(), SOCKET_TAG_WAKE);
+    if (wakeTag != w.readySockets.end()) {
+        char drain[64];
+        while (read(w.wakePipe[0], drain, sizeof(drain)) > 0) {
+        }
+        w.readySockets.erase(wakeTag);
+    }
+}
+
+void UDPReceiver::wake(Worker& w) {
+    if (w.wakePipe[1] < 0) return;
+    char byte = 1;
+    ssize_t written = write(w.wakePipe[1], &byte, 1);
+    (void)written;  // a full pipe already wakes the worker
+}
+
+void UDPReceiver::updateSharedMemory(Worker& w) {
+    if (!m_sharedMemory) return;
+
+    auto now = std::chrono::steady_clock::now();
+    if (now < w.nextRingCheck) return;
+    w.nextRingCheck = now + std::chrono::seconds(1);
+
+    for (int i = w.index; i < NUM_ROVERS; i += getWorkerCount()) {
+        ShmRingReader& ring = m_rings[i];
+        if (ring.isOpen() && !ring.writerAlive()) {
+            ring.close();
+            std::cout << "Rover " << (i + 1) << ": shared memory closed, using UDP\n";
+        } else if (!ring.isOpen() && ring.open(i + 1)) {
+            std::cout << "Rover " << (i + 1) << ": receiving over shared memory\n";
+        }
+        m_ringActive[i] = ring.isOpen();
+    }
+}
+
+// Shared-memory records are handled in place, without the copy into
+// the receive buffer. The sockets are still drained, for datagrams sent
+// before the emulator noticed us.
+void UDPReceiver::pollSharedMemory(Worker& w) {
+    for (int i = w.index; i < NUM_ROVERS; i += getWorkerCount()) {
+        if (!m_rings[i].isOpen()) continue;
+        m_rings[i].poll([this, i](uint16_t stream, const char* data, size_t size) {
+            switch (stream) {
+            case SHM_STREAM_POSE:  handlePose(i, data, size); break;
+            case SHM_STREAM_LIDAR: handleLidar(i, data, size); break;
+            case SHM_STREAM_TELEM: handleTelemetry(i, data, size); break;
+            case SHM_STREAM_STATE: handleState(i, data, size); break;
+            default: break;
             }
+        });
+    }
+}
+
+// Reads 'sock' batch by batch until it comes up short, i.e. the socket
+// is empty, and hands each datagram that fit its slot to
+// handler(data, size)
+template <typename Handler>
+void UDPReceiver::drainSocket(Worker& w, int sock, uint32_t& overflowCount, Handler&& handler) {
+    while (true) {
+        int n = receiveBatch(w, sock, overflowCount);
+        for (int k = 0; k < n; k++) {
+            if (!checkTruncation(w, w.batchLengths[k])) continue;
+            handler(w.recvBuffer.data() + k * m_slotSize, w.batchLengths[k]);
         }
+        if (n < m_batchSize) break;
+    }
+}
 
-        // Receive LiDAR packets - always process (emulator handles pause)
-        while (true) {
-            ssize_t n = recv(m_lidarSockets[i], buffer, sizeof(buffer), 0);
-            if (n <= 0) break;
-            
-            if (n >= static_cast<ssize_t>(sizeof(LidarPacketHeader))) {
-                LidarPacketHeader header;
-                std::memcpy(&header, buffer, sizeof(LidarPacketHeader));
-                
-                // Get or create scan builder for this timestamp
-                auto& builders = m_lidarBuilders[i];
-                auto& builder = builders[header.timestamp];
-                
-                if (builder.totalChunks == 0) {
-                    builder.timestamp = header.timestamp;
-                    builder.totalChunks = header.totalChunks;
-                    builder.receivedChunks = 0;
-                    builder.points.reserve(header.totalChunks * MAX_LIDAR_POINTS_PER_PACKET);
-                    builder.chunkReceived.resize(header.totalChunks, false);
-                }
-
-                // Store points from this chunk
-                if (header.chunkIndex < builder.totalChunks && !builder.chunkReceived[header.chunkIndex]) {
-                    builder.chunkReceived[header.chunkIndex] = true;
-                    builder.receivedChunks++;
-                    
-                    const LidarPoint* points = reinterpret_cast<const LidarPoint*>(buffer + sizeof(LidarPacketHeader));
-                    for (uint32_t j = 0; j < header.pointsInThisChunk; j++) {
-                        builder.points.push_back(points[j]);
-                    }
-                }
-
-                // Check if scan is complete
-                if (builder.receivedChunks >= builder.totalChunks) {
-                    m_dataManager->addPointCloud(roverId, builder.points);
-                    builders.erase(header.timestamp);
-                }
-
-                // Clean up old incomplete scans (older than 1 second)
-                auto it = builders.begin();
-                while (it != builders.end()) {
-                    if (header.timestamp - it->first > 1.0) {
-                        it = builders.erase(it);
-                    } else {
-                        ++it;
-                    }
-                }
+void UDPReceiver::receiveMultiplexed(Worker& w) {
+    drainSocket(w, w.ingestSocket, w.ingestOverflows, [this, &w](const char* data, size_t length) {
+        if (length < MuxHeaderView::SIZE) {
+            w.unroutedDatagrams++;
+            return;
+        }
+        MuxHeaderView mux(data);
+        const uint32_t roverId = mux.roverId();
+        if (mux.magic() != MUX_MAGIC || mux.version() != MUX_PROTOCOL_VERSION ||
+            roverId < 1 || roverId > static_cast<uint32_t>(NUM_ROVERS)) {
+            if (w.unroutedDatagrams++ == 0) {
+                std::cerr << "Ignoring multiplexed datagrams that aren't from rovers 1-" << NUM_ROVERS
+                          << " (first: rover " << roverId << ")\n";
             }
+            return;
+        }
+
+        // Only the owning worker may touch a rover's reassembler and
+        // trackers. The filter makes sure of that, except for what the
+        // first socket queued before the others joined its group.
+        int roverIndex = static_cast<int>(roverId) - 1;
+        if (getWorker(roverIndex) != w.index) {
+            w.misroutedDatagrams++;
+            return;
         }
+        const char* packet = data + MuxHeaderView::SIZE;
+        size_t size = length - MuxHeaderView::SIZE;
+        switch (mux.stream()) {
+        case MUX_STREAM_POSE:  handlePose(roverIndex, packet, size); break;
+        case MUX_STREAM_LIDAR: handleLidar(roverIndex, packet, size); break;
+        case MUX_STREAM_TELEM: handleTelemetry(roverIndex, packet, size); break;
+        case MUX_STREAM_STATE: handleState(roverIndex, packet, size); break;
+        default: w.unroutedDatagrams++; break;
+        }
+    });
+}
+
+// All streams are always processed; the emulator handles pause, and
+// telemetry carries the button states
+void UDPReceiver::receiveRoverSocket(Worker& w, int roverIndex, int stream) {
+    const int i = roverIndex;
+    uint32_t& overflows = m_socketOverflowCounts[i][stream];
+    const uint32_t overflowsBefore = overflows;
+
+    switch (stream) {
+    case STREAM_POSE:
+        drainSocket(w, m_poseSockets[i], overflows, [this, i](const char* data, size_t size) {
+            handlePose(i, data, size);
+        });
+        break;
+    case STREAM_LIDAR:
+        drainSocket(w, m_lidarSockets[i], overflows, [this, i](const char* data, size_t size) {
+            handleLidar(i, data, size);
+        });
+        break;
+    case STREAM_TELEM:
+        drainSocket(w, m_telemSockets[i], overflows, [this, i](const char* data, size_t size) {
+            handleTelemetry(i, data, size);
+        });
+        break;
+    default:
+        break;
+    }
+
+    uint32_t dropped = overflows - overflowsBefore;
+    if (dropped > 0) {
+        m_linkStats[i].socketOverflows += dropped;
     }
 }
 
+// One recvmmsg (recvmsg where there is none) of up to m_batchSize
+// datagrams into the worker's batch slots. Sockets are read with
+// MSG_TRUNC, so batchLengths holds full datagram lengths and oversized
+// ones can be told apart. Returns the number of datagrams, 0 if the
+// socket was empty.
+int UDPReceiver::receiveBatch(Worker& w, int sock, uint32_t& overflowCount) {
+#ifdef __linux__
+    for (int k = 0; k < m_batchSize; k++) {
+        w.batchIov[k].iov_base = w.recvBuffer.data() + k * m_slotSize;
+        w.batchIov[k].iov_len = m_slotSize;
+        msghdr& msg = w.batchMsgs[k].msg_hdr;
+        std::memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &w.batchIov[k];
+        msg.msg_iovlen = 1;
+        msg.msg_control = w.batchControl.data() + k * CONTROL_SPACE;
+        msg.msg_controllen = CONTROL_SPACE;
+    }
+    int n = recvmmsg(sock, w.batchMsgs.data(), static_cast<unsigned int>(m_batchSize),
+                     MSG_TRUNC | MSG_DONTWAIT, nullptr);
+    w.receiveCalls++;
+    if (n <= 0) return 0;
+    for (int k = 0; k < n; k++) {
+        w.batchLengths[k] = w.batchMsgs[k].msg_len;
+        readOverflowCount(w, w.batchMsgs[k].msg_hdr, overflowCount);
+    }
+#else
+    w.batchIov[0].iov_base = w.recvBuffer.data();
+    w.batchIov[0].iov_len = m_slotSize;
+    msghdr msg;
+    std::memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &w.batchIov[0];
+    msg.msg_iovlen = 1;
+    msg.msg_control = w.batchControl.data();
+    msg.msg_controllen = CONTROL_SPACE;
+    ssize_t length = recvmsg(sock, &msg, MSG_TRUNC | MSG_DONTWAIT);
+    w.receiveCalls++;
+    if (length < 0) return 0;
+    w.batchLengths[0] = static_cast<size_t>(length);
+    readOverflowCount(w, msg, overflowCount);
+    const int n = 1;
+#endif
+    w.datagrams += static_cast<uint64_t>(n);
+    return n;
+}
+
+// Picks up the socket's drop count, which the kernel attaches
+// (SO_RXQ_OVFL) once it is non-zero. The count is cumulative per
+// socket: 'overflowCount' holds the last one seen, and whatever it grew
+// by is added to the worker's socketOverflows.
+void UDPReceiver::readOverflowCount(Worker& w, msghdr& msg, uint32_t& overflowCount) {
+#ifdef SO_RXQ_OVFL
+    for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SO_RXQ_OVFL) {
+            uint32_t count;
+            std::memcpy(&count, CMSG_DATA(cmsg), sizeof(count));
+            w.socketOverflows += count - overflowCount;
+            overflowCount = count;
+        }
+    }
+#else
+    (void)w;
+    (void)msg;
+    (void)overflowCount;
+#endif
+}
+
+// Datagrams larger than their slot are detected (see receiveBatch)
+// instead of parsed half-read. Returns false for such a datagram.
+bool UDPReceiver::checkTruncation(Worker& w, size_t length) {
+    if (length <= m_slotSize) {
+        return true;
+    }
+    if (w.truncatedDatagrams++ == 0) {
+        std::cerr << "Datagram of " << length << " bytes exceeds the " << m_slotSize
+                  << "-byte receive buffer; raise --max-datagram or lower the emulator's"
+                  << " --chunk-bytes\n";
+    }
+    return false;
+}
+
+// Once a second: the rates getLoopRates() reports
+void UDPReceiver::updateLoopRates(Worker& w) {
+    auto now = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(now - w.ratesStart).count();
+    if (seconds < 1.0) return;
+
+    w.wakeupsPerSecond = (w.wakeups - w.ratesWakeups) / seconds;
+    w.callsPerSecond = (w.receiveCalls - w.ratesCalls) / seconds;
+    w.datagramsPerSecond = (w.datagrams - w.ratesDatagrams) / seconds;
+    w.ratesStart = now;
+    w.ratesWakeups = w.wakeups;
+    w.ratesCalls = w.receiveCalls;
+    w.ratesDatagrams = w.datagrams;
+}
+
+ReceiveLoopRates UDPReceiver::getLoopRates() const {
+    ReceiveLoopRates rates;
+    for (const auto& w : m_workers) {
+        rates.wakeupsPerSecond += w->wakeupsPerSecond;
+        rates.callsPerSecond += w->callsPerSecond;
+        rates.datagramsPerSecond += w->datagramsPerSecond;
+    }
+    return rates;
+}
+
+uint64_t UDPReceiver::getTruncatedDatagrams() const {
+    uint64_t total = 0;
+    for (const auto& w : m_workers) total += w->truncatedDatagrams;
+    return total;
+}
+
+uint64_t UDPReceiver::getUnroutedDatagrams() const {
+    uint64_t total = 0;
+    for (const auto& w : m_workers) total += w->unroutedDatagrams;
+    return total;
+}
+
+uint64_t UDPReceiver::getMisroutedDatagrams() const {
+    uint64_t total = 0;
+    for (const auto& w : m_workers) total += w->misroutedDatagrams;
+    return total;
+}
+
+uint64_t UDPReceiver::getSocketOverflows() const {
+    uint64_t total = 0;
+    for (const auto& w : m_workers) total += w->socketOverflows;
+    return total;
+}
+
+void UDPReceiver::handlePose(int roverIndex, const char* data, size_t size) {
+    // The pose port also carries state packets, told apart by size
+    if (size == StatePacketView::SIZE) {
+        handleState(roverIndex, data, size);
+        return;
+    }
+    if (size != PosePacketView::SIZE) return;
+    PosePacketView pose(data);
+    m_linkStats[roverIndex].pose.record(pose.sequence());
+    m_dataManager->updateRoverPose(roverIndex + 1, pose.read());
+}
+
+void UDPReceiver::handleTelemetry(int roverIndex, const char* data, size_t size) {
+    if (size != VehicleTelemView::SIZE) return;
+    VehicleTelemView telem(data);
+    m_linkStats[roverIndex].telemetry.record(telem.sequence());
+    m_dataManager->updateRoverTelemetry(roverIndex + 1, telem.read());
+}
+
+void UDPReceiver::handleState(int roverIndex, const char* data, size_t size) {
+    if (size != StatePacketView::SIZE) return;
+    StatePacketView state(data);
+    m_linkStats[roverIndex].state.record(state.sequence());
+    m_dataManager->updateRoverState(roverIndex + 1, state.read());
+}
+
+void UDPReceiver::handleLidar(int roverIndex, const char* data, size_t size) {
+    LidarPacketHeaderView header(data);
+    if (PacketParser::checkLidarChunk(header, size)) {
+        m_linkStats[roverIndex].lidar.record(header.sequence());
+        handleLidarChunk(roverIndex, header);
+    }
+}
+
+void UDPReceiver::handleLidarChunk(int roverIndex, const LidarPacketHeaderView& header) {
+    LidarReassembler& reassembler = m_reassemblers[roverIndex];
+    LidarScan* scan = reassembler.addChunk(header);
+
+    LidarIngestStats& stats = m_lidarStats[roverIndex];
+    stats.incompleteScans = reassembler.getIncompleteScans();
+    if (scan) {
+        completeScan(roverIndex, *scan);
+    }
+}
+
+void UDPReceiver::completeScan(int roverIndex, LidarScan& scan) {
+    LidarIngestStats& stats = m_lidarStats[roverIndex];
+    stats.scans++;
+    stats.pointsReceived += scan.points.size();
+    if (scan.flags & LIDAR_FLAG_DELTA) {
+        stats.deltaScans++;
+        stats.pointsSuppressed += scan.suppressedPoints;
+    }
+    stats.allocations += scan.allocations;
+    stats.scanAllocations = scan.allocations;
+    // The points move on; the slot keeps the recycled buffer
+    m_dataManager->addPointCloud(roverIndex + 1, scan.points);
+}
+
 void UDPReceiver::sendCommand(int roverId, uint8_t buttonStates) {
     if (m_cmdSocket < 0 || roverId < 1 || roverId > NUM_ROVERS) return;
 
@@ -193,11 +660,31 @@ void UDPReceiver::sendCommand(int roverId, uint8_t buttonStates) {
 }
 
 void UDPReceiver::shutdown() {
+    stop();
+    for (int i = 0; i < NUM_ROVERS; i++) {
+        m_rings[i].close();
+        m_ringActive[i] = false;
+    }
     for (int i = 0; i < NUM_ROVERS; i++) {
         if (m_poseSockets[i] >= 0) close(m_poseSockets[i]);
         if (m_lidarSockets[i] >= 0) close(m_lidarSockets[i]);
         if (m_telemSockets[i] >= 0) close(m_telemSockets[i]);
     }
+    for (auto& w : m_workers) {
+        if (w->ingestSocket >= 0) close(w->ingestSocket);
+        w->ingestSocket = -1;
+#ifdef __linux__
+        if (w->epoll >= 0) close(w->epoll);
+        w->epoll = -1;
+#else
+        w->pollFds.clear();
+        w->pollTags.clear();
+#endif
+        for (int& fd : w->wakePipe) {
+            if (fd >= 0) close(fd);
+            fd = -1;
+        }
+    }
     if (m_cmdSocket >= 0) close(m_cmdSocket);
     
     m_poseSockets.fill(-1);
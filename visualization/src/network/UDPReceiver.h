@@ -1,50 +1,242 @@
 #pragma once
 
 #include "common.h"
+#include "network/LidarReassembler.h"
 #include "network/PacketParser.h"
+#include "network/SequenceTracker.h"
+#include "network/ShmRing.h"
 #include <array>
-#include <map>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#ifndef __linux__
+#include <poll.h>
+#endif
 
 namespace terrafirma {
 
 class DataManager;
 
+// Runtime network settings, filled from the command line (see main.cpp)
+struct NetworkConfig {
+    // Receive buffer size in bytes; must cover the emulator's --chunk-bytes
+    size_t maxDatagramBytes = MAX_DATAGRAM_SIZE;
+    // Read from the emulator's shared-memory rings (--shm) when present
+    bool sharedMemory = true;
+    // One socket on INGEST_PORT for every rover and stream (emulator --mux)
+    // instead of three ports per rover
+    bool multiplexed = false;
+    // Datagrams read per recvmmsg call; each one gets a maxDatagramBytes
+    // buffer per worker, so the batches cost workers * batch *
+    // maxDatagramBytes of memory
+    int receiveBatch = 16;
+    // Receive threads; rovers are dealt out to them (rover i to worker
+    // i % workers), at most one worker per rover
+    int receiveWorkers = 1;
+};
+
+// Receive loop rates over the last second, summed over the workers
+struct ReceiveLoopRates {
+    double wakeupsPerSecond = 0.0;     // returns from the wait, timeouts included
+    double callsPerSecond = 0.0;       // recvmmsg (recvmsg) calls, empty ones included
+    double datagramsPerSecond = 0.0;
+};
+
+// Per-rover LiDAR counters; written by the rover's receive worker, read
+// by the UI
+struct LidarIngestStats {
+    std::atomic<uint64_t> scans{0};
+    std::atomic<uint64_t> deltaScans{0};         // scans flagged LIDAR_FLAG_DELTA
+    std::atomic<uint64_t> pointsReceived{0};
+    std::atomic<uint64_t> pointsSuppressed{0};   // left out by the sender's delta filter
+    std::atomic<uint64_t> incompleteScans{0};    // given up with chunks missing
+    // Scan buffers grown on the way from chunks to the integration
+    // queue: in total, and for the latest scan (zero in steady state)
+    std::atomic<uint64_t> allocations{0};
+    std::atomic<uint32_t> scanAllocations{0};
+};
+
+// Sequence tracking for one rover's three streams
+struct RoverLinkStats {
+    SequenceTracker pose;
+    SequenceTracker lidar;      // per chunk
+    SequenceTracker telemetry;
+    SequenceTracker state;      // combined packets (emulator --state)
+    // Datagrams the kernel dropped because one of the rover's sockets had
+    // a full receive queue (SO_RXQ_OVFL); per-rover sockets only
+    std::atomic<uint64_t> socketOverflows{0};
+};
+
 class UDPReceiver {
 public:
-    UDPReceiver(DataManager* dataManager);
+    UDPReceiver(DataManager* dataManager, const NetworkConfig& config = NetworkConfig());
     ~UDPReceiver();
 
     bool init();
-    void update();
+    // Starts the receive workers; each runs until stop()
+    void start();
+    // Wakes the workers and waits for them to finish
+    void stop();
     void shutdown();
     
     void sendCommand(int roverId, uint8_t buttonStates);
 
+    // Datagrams dropped because they didn't fit the receive buffer
+    uint64_t getTruncatedDatagrams() const;
+    // Multiplexed datagrams dropped for a bad header or a rover ID
+    // outside 1..NUM_ROVERS
+    uint64_t getUnroutedDatagrams() const;
+    // Multiplexed datagrams dropped because they reached a worker that
+    // doesn't own their rover (queued before steering took effect)
+    uint64_t getMisroutedDatagrams() const;
+    // Datagrams the kernel dropped for a full socket receive queue, over
+    // every socket (the only count available in multiplexed mode)
+    uint64_t getSocketOverflows() const;
+
+    ReceiveLoopRates getLoopRates() const;
+    int getWorkerCount() const { return static_cast<int>(m_workers.size()); }
+    // Index of the worker that receives the rover's streams
+    int getWorker(int roverIndex) const { return roverIndex % getWorkerCount(); }
+
+    const LidarIngestStats& getLidarStats(int roverIndex) const { return m_lidarStats[roverIndex]; }
+    const RoverLinkStats& getLinkStats(int roverIndex) const { return m_linkStats[roverIndex]; }
+
+    bool isMultiplexed() const { return m_multiplexed; }
+
+    // True while the rover's streams arrive through shared memory
+    bool isSharedMemoryActive(int roverIndex) const { return m_ringActive[roverIndex]; }
+
 private:
-    void receivePackets();
+    // Socket tags for the wait: roverIndex * SOCKET_TAG_STRIDE + stream
+    // (STREAM_* below) for the per-rover sockets
+    static constexpr uint32_t SOCKET_TAG_STRIDE = 4;
+    static constexpr uint32_t SOCKET_TAG_INGEST = 0xFFFFFFFE;
+    static constexpr uint32_t SOCKET_TAG_WAKE = 0xFFFFFFFF;
+    enum RoverStream { STREAM_POSE = 0, STREAM_LIDAR = 1, STREAM_TELEM = 2 };
+
+    // One receive thread and everything only it touches: its wait set,
+    // receive batch, counters and, in multiplexed mode, its own socket
+    // in the SO_REUSEPORT group on INGEST_PORT. Per-rover state (sockets,
+    // rings, reassembly, link stats) lives in the arrays below and is
+    // only touched by the rover's worker, so workers share nothing but
+    // the DataManager they hand their data to.
+    struct Worker {
+        int index = 0;                      // owns rovers i with getWorker(i) == index
+        std::thread thread;
+
+        // Receive batch, allocated once: receiveBatch slots of
+        // maxDatagramBytes each, with their recvmmsg descriptors
+        std::vector<char> recvBuffer;
+        std::vector<size_t> batchLengths;
+        std::vector<iovec> batchIov;
+        std::vector<char> batchControl;
+#ifdef __linux__
+        std::vector<mmsghdr> batchMsgs;
+#endif
+
+        // Waiting for datagrams: an epoll set over the worker's sockets
+        // (poll() where there is no epoll), plus a pipe that stop()
+        // writes to
+        int wakePipe[2] = { -1, -1 };
+#ifdef __linux__
+        int epoll = -1;
+#else
+        std::vector<pollfd> pollFds;
+        std::vector<uint32_t> pollTags;
+#endif
+        std::vector<uint32_t> readySockets;   // tags returned by the last wait
+
+        // Multiplexed mode: this worker's ingest socket
+        int ingestSocket = -1;
+        uint32_t ingestOverflows = 0;
+
+        std::chrono::steady_clock::time_point nextRingCheck;
+
+        std::atomic<uint64_t> truncatedDatagrams{0};
+        std::atomic<uint64_t> unroutedDatagrams{0};
+        std::atomic<uint64_t> misroutedDatagrams{0};
+        std::atomic<uint64_t> socketOverflows{0};
+
+        // Loop counters and their rates over the last second
+        uint64_t wakeups = 0;
+        uint64_t receiveCalls = 0;
+        uint64_t datagrams = 0;
+        std::chrono::steady_clock::time_point ratesStart;
+        uint64_t ratesWakeups = 0;
+        uint64_t ratesCalls = 0;
+        uint64_t ratesDatagrams = 0;
+        std::atomic<double> wakeupsPerSecond{0.0};
+        std::atomic<double> callsPerSecond{0.0};
+        std::atomic<double> datagramsPerSecond{0.0};
+    };
+
+    bool initWorker(Worker& w);
+    bool initMultiplexed();
+    bool steerMultiplexed();
+    bool initRoverSockets(int roverIndex);
+    bool watchSocket(Worker& w, int sock, uint32_t tag);
+    void run(Worker& w);
+    // Blocks until one of the worker's sockets has datagrams (or, while
+    // a shared-memory ring is attached, for at most 1 ms), then drains
+    // what is ready
+    void update(Worker& w);
+    int waitTimeoutMs(const Worker& w) const;
+    void waitForDatagrams(Worker& w, int timeoutMs);
+    void wake(Worker& w);
+    void pollSharedMemory(Worker& w);
+    void receiveMultiplexed(Worker& w);
+    void receiveRoverSocket(Worker& w, int roverIndex, int stream);
+    template <typename Handler>
+    void drainSocket(Worker& w, int sock, uint32_t& overflowCount, Handler&& handler);
+    int receiveBatch(Worker& w, int sock, uint32_t& overflowCount);
+    void readOverflowCount(Worker& w, msghdr& msg, uint32_t& overflowCount);
+    bool checkTruncation(Worker& w, size_t length);
     bool createSocket(int& sock, int port);
     void setNonBlocking(int sock);
+    void updateSharedMemory(Worker& w);
+    void updateLoopRates(Worker& w);
+    void handlePose(int roverIndex, const char* data, size_t size);
+    void handleTelemetry(int roverIndex, const char* data, size_t size);
+    void handleState(int roverIndex, const char* data, size_t size);
+    void handleLidar(int roverIndex, const char* data, size_t size);
+    void handleLidarChunk(int roverIndex, const LidarPacketHeaderView& header);
 
     DataManager* m_dataManager;
     PacketParser m_parser;
 
-    // Sockets for receiving (per rover)
+    size_t m_slotSize;
+    int m_batchSize;
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::atomic<bool> m_running{false};
+
+    bool m_multiplexed;
+
+    // Sockets for receiving (per rover), unused in multiplexed mode
     std::array<int, NUM_ROVERS> m_poseSockets;
     std::array<int, NUM_ROVERS> m_lidarSockets;
     std::array<int, NUM_ROVERS> m_telemSockets;
+    // Last SO_RXQ_OVFL count seen per socket (the kernel's count is
+    // cumulative), indexed by RoverStream
+    std::array<std::array<uint32_t, 3>, NUM_ROVERS> m_socketOverflowCounts{};
     
     // Socket for sending commands
     int m_cmdSocket = -1;
 
-    // LiDAR chunk reassembly (per rover)
-    struct LidarScanBuilder {
-        double timestamp = 0.0;
-        uint32_t totalChunks = 0;
-        uint32_t receivedChunks = 0;
-        std::vector<LidarPoint> points;
-        std::vector<bool> chunkReceived;
-    };
-    std::array<std::map<double, LidarScanBuilder>, NUM_ROVERS> m_lidarBuilders;
+    // Same-host transport. Attaching is retried once per second; while
+    // a rover's ring is attached the emulator sends nothing over UDP.
+    bool m_sharedMemory;
+    std::array<ShmRingReader, NUM_ROVERS> m_rings;
+    std::array<std::atomic<bool>, NUM_ROVERS> m_ringActive{};
+
+    // LiDAR chunk reassembly, one ring of scan slots per rover
+    void completeScan(int roverIndex, LidarScan& scan);
+    std::array<LidarReassembler, NUM_ROVERS> m_reassemblers;
+    std::array<LidarIngestStats, NUM_ROVERS> m_lidarStats;
+    std::array<RoverLinkStats, NUM_ROVERS> m_linkStats;
 
     bool m_initialized = false;
 };
@@ -0,0 +1,293 @@
+#include <iostream>
+#include <vector>
+#include <map>
+#include <random>
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+#include <new>
+#include <iomanip>
+#include <algorithm>
+
+#include "rover_protocol.h"
+#include "network/LidarReassembler.h"
+#include "data/ScanQueue.h"
+
+using namespace terrafirma;
+
+// --------------------------------------------------------------------
+// LiDAR reassembly benchmark.
+//
+// Splits synthetic scans into wire-format chunks the way the emulator
+// does with --chunk-bytes 1472, applies loss and/or reordering (seeded,
+// untimed), then times two reassemblers over the same datagrams:
+//   legacy  - the original std::map<double, builder> keyed by timestamp,
+//             with vector<bool> chunk flags, push_back per point and a
+//             stale-scan sweep per chunk
+//   slots   - LidarReassembler alone
+//   handoff - LidarReassembler plus the hand-off of every scan through
+//             ScanQueue, popped at once as the integration thread
+//             would, as in the visualization
+// Reported per scenario: time per chunk, scans completed, how many of
+// them have their points in the sender's order, and heap allocations
+// per completed scan (counted by the global operator new below).
+// --------------------------------------------------------------------
+
+static uint64_t g_allocations = 0;
+
+void* operator new(size_t size)
+{
+    ++g_allocations;
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+// --------------------------------------------------------------------
+// The original implementation, kept as the baseline. Only the header
+// access changed (views instead of a memcpy into the packed struct).
+// --------------------------------------------------------------------
+class LegacyReassembler {
+public:
+    // Returns the completed scan's points, or nullptr
+    const std::vector<LidarPoint>* addChunk(const char* buffer)
+    {
+        LidarPacketHeaderView header(buffer);
+
+        // Get or create scan builder for this timestamp
+        auto& builder = m_builders[header.timestamp()];
+
+        if (builder.totalChunks == 0) {
+            builder.timestamp = header.timestamp();
+            builder.totalChunks = header.totalChunks();
+            builder.receivedChunks = 0;
+            builder.points.reserve(header.totalChunks() * header.pointsInThisChunk());
+            builder.chunkReceived.resize(header.totalChunks(), false);
+        }
+
+        // Store points from this chunk
+        if (header.chunkIndex() < builder.totalChunks && !builder.chunkReceived[header.chunkIndex()]) {
+            builder.chunkReceived[header.chunkIndex()] = true;
+            builder.receivedChunks++;
+
+            const char* points = buffer + LidarPacketHeaderView::SIZE;
+            for (uint32_t j = 0; j < header.pointsInThisChunk(); j++) {
+                builder.points.push_back(LidarPointView(points + j * sizeof(LidarPoint)).read());
+            }
+        }
+
+        // Check if scan is complete
+        const std::vector<LidarPoint>* complete = nullptr;
+        if (builder.receivedChunks >= builder.totalChunks) {
+            m_completed.swap(builder.points);
+            complete = &m_completed;
+            m_builders.erase(header.timestamp());
+        }
+
+        // Clean up old incomplete scans (older than 1 second)
+        auto it = m_builders.begin();
+        while (it != m_builders.end()) {
+            if (header.timestamp() - it->first > 1.0) {
+                it = m_builders.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        return complete;
+    }
+
+private:
+    struct LidarScanBuilder {
+        double timestamp = 0.0;
+        uint32_t totalChunks = 0;
+        uint32_t receivedChunks = 0;
+        std::vector<LidarPoint> points;
+        std::vector<bool> chunkReceived;
+    };
+    std::map<double, LidarScanBuilder> m_builders;
+    std::vector<LidarPoint> m_completed;
+};
+
+// --------------------------------------------------------------------
+// Synthetic traffic
+// --------------------------------------------------------------------
+static const size_t SCAN_POINTS = 20000;
+static const size_t CHUNK_BYTES = 1472;
+static const uint32_t SCANS = 1000;
+
+struct Datagram {
+    uint32_t scanId;
+    std::vector<char> bytes;
+};
+
+// Point i of every scan is (i, scanId, 0), so the order can be checked
+static std::vector<Datagram> makeTraffic()
+{
+    const size_t perChunk = (CHUNK_BYTES - sizeof(LidarPacketHeader)) / sizeof(LidarPoint);
+    const uint32_t totalChunks = static_cast<uint32_t>((SCAN_POINTS + perChunk - 1) / perChunk);
+    std::vector<Datagram> traffic;
+    uint32_t sequence = 0;
+    for (uint32_t scanId = 0; scanId < SCANS; ++scanId) {
+        for (uint32_t c = 0; c < totalChunks; ++c) {
+            size_t first = c * perChunk;
+            size_t count = std::min(perChunk, SCAN_POINTS - first);
+            LidarPacketHeader header;
+            std::memset(&header, 0, sizeof(header));
+            header.magic = LIDAR_MAGIC;
+            header.version = LIDAR_PROTOCOL_VERSION;
+            header.encoding = LIDAR_ENCODING_FLOAT32;
+            header.timestamp = scanId * 0.1;
+            header.scanId = scanId;
+            header.sequence = sequence++;
+            header.chunkIndex = c;
+            header.totalChunks = totalChunks;
+            header.pointsInThisChunk = static_cast<uint32_t>(count);
+            header.firstPoint = static_cast<uint32_t>(first);
+            header.scanPoints = static_cast<uint32_t>(SCAN_POINTS);
+            toWire(header);
+
+            Datagram d;
+            d.scanId = scanId;
+            d.bytes.resize(sizeof(header) + count * sizeof(LidarPoint));
+            std::memcpy(d.bytes.data(), &header, sizeof(header));
+            for (size_t i = 0; i < count; ++i) {
+                LidarPoint p = { static_cast<float>(first + i), static_cast<float>(scanId), 0.0f };
+                std::memcpy(d.bytes.data() + sizeof(header) + i * sizeof(LidarPoint), &p, sizeof(p));
+            }
+            traffic.push_back(std::move(d));
+        }
+    }
+    return traffic;
+}
+
+// Drops each datagram with probability 'loss', then shuffles within
+// windows of 'reorder' datagrams (0 = keep the order)
+static std::vector<const Datagram*> impair(const std::vector<Datagram>& traffic, double loss, size_t reorder)
+{
+    std::mt19937_64 rng(42);
+    std::bernoulli_distribution drop(loss);
+    std::vector<const Datagram*> out;
+    for (const Datagram& d : traffic) {
+        if (!drop(rng)) {
+            out.push_back(&d);
+        }
+    }
+    for (size_t i = 0; reorder > 1 && i < out.size(); i += reorder) {
+        std::shuffle(out.begin() + i, out.begin() + std::min(i + reorder, out.size()), rng);
+    }
+    return out;
+}
+
+struct BenchResult {
+    double seconds = 0.0;
+    uint64_t scans = 0;
+    uint64_t inOrder = 0;      // completed scans with points in sender order
+    uint64_t allocations = 0;  // during the timed pass
+};
+
+static bool pointsInOrder(const std::vector<LidarPoint>& points)
+{
+    for (size_t i = 0; i < points.size(); ++i) {
+        if (points[i].x != static_cast<float>(i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 'add' returns the completed scan's points or nullptr. The first few
+// completed scans warm up the buffers, reassembler slots and queue
+// cells alike, untimed. The order check is timed for every reassembler alike.
+template <typename Reassembler, typename AddFn>
+static BenchResult run(const std::vector<const Datagram*>& datagrams, AddFn add)
+{
+    BenchResult result;
+    Reassembler reassembler;
+    size_t start = 0;
+    // Every queue cell must have been pushed once, and every slot handed
+    // back one of the cells' initial empty buffers, so count completions
+    uint32_t warmup = ScanQueue::CAPACITY + 2 * LidarReassembler::SLOTS;
+    while (start < datagrams.size() && warmup > 0) {
+        warmup -= add(reassembler, datagrams[start++]->bytes.data()) != nullptr;
+    }
+
+    uint64_t allocations = g_allocations;
+    auto t0 = std::chrono::steady_clock::now();
+    for (size_t i = start; i < datagrams.size(); ++i) {
+        if (const std::vector<LidarPoint>* scan = add(reassembler, datagrams[i]->bytes.data())) {
+            ++result.scans;
+            result.inOrder += pointsInOrder(*scan);
+        }
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    result.allocations = g_allocations - allocations;
+    return result;
+}
+
+static void report(const char* name, const BenchResult& r, size_t chunks, const BenchResult* baseline)
+{
+    std::cout << "  " << std::left << std::setw(8) << name << std::right << std::fixed
+              << std::setprecision(0) << std::setw(8) << (r.seconds * 1e9 / chunks) << " ns/chunk"
+              << std::setw(7) << r.scans << " scans"
+              << std::setw(7) << r.inOrder << " in order"
+              << std::setprecision(2) << std::setw(8)
+              << (r.scans ? static_cast<double>(r.allocations) / r.scans : 0.0) << " allocs/scan";
+    if (baseline) {
+        std::cout << std::setprecision(1) << std::setw(7) << (baseline->seconds / r.seconds) << "x";
+    }
+    std::cout << "\n";
+}
+
+int main()
+{
+    std::vector<Datagram> traffic = makeTraffic();
+    std::cout << SCANS << " scans of " << SCAN_POINTS << " points, " << traffic.size() / SCANS
+              << " chunks each (" << CHUNK_BYTES << "-byte datagrams)\n";
+
+    struct Scenario {
+        const char* name;
+        double loss;
+        size_t reorder;
+    };
+    const Scenario scenarios[] = {
+        { "clean", 0.0, 0 },
+        { "loss 1%", 0.01, 0 },
+        { "reorder 16", 0.0, 16 },
+        { "loss 1% + reorder 16", 0.01, 16 },
+    };
+
+    for (const Scenario& s : scenarios) {
+        std::vector<const Datagram*> datagrams = impair(traffic, s.loss, s.reorder);
+        std::cout << "\n" << s.name << " (" << datagrams.size() << " chunks)\n";
+
+        BenchResult legacy = run<LegacyReassembler>(datagrams, [](LegacyReassembler& r, const char* data) {
+            return r.addChunk(data);
+        });
+        BenchResult slots = run<LidarReassembler>(datagrams,
+            [](LidarReassembler& r, const char* data) -> const std::vector<LidarPoint>* {
+                const LidarScan* scan = r.addChunk(LidarPacketHeaderView(data));
+                return scan ? &scan->points : nullptr;
+            });
+        // The popped entry's points stay put until the cell is pushed to
+        // again, long enough for the order check
+        ScanQueue queue;
+        BenchResult handoff = run<LidarReassembler>(datagrams,
+            [&queue](LidarReassembler& r, const char* data) -> const std::vector<LidarPoint>* {
+                LidarScan* scan = r.addChunk(LidarPacketHeaderView(data));
+                if (!scan || !queue.push(1, scan->points)) {
+                    return nullptr;
+                }
+                const ScanQueue::Entry* entry = queue.front();
+                queue.pop();
+                return &entry->points;
+            });
+        report("legacy", legacy, datagrams.size(), nullptr);
+        report("slots", slots, datagrams.size(), &legacy);
+        report("handoff", handoff, datagrams.size(), &legacy);
+    }
+    return 0;
+}
@@ -5,6 +5,7 @@
 #include <GLFW/glfw3.h>
 #include <cstdio>
 #include <iostream>
+#include <utility>
 
 namespace terrafirma {
 
@@ -384,6 +385,71 @@ void UIManager::renderStatusPanel(DataManager* dataManager, UDPReceiver* udpRece
         ImGui::PopStyleColor(3);
     }
     
+    ImGui::Spacing();
+    ImGui::Spacing();
+
+    // LiDAR ingest (delta scans carry only voxels the rover hadn't sent recently)
+    const LidarIngestStats& lidar = udpReceiver->getLidarStats(selectedRover);
+    uint64_t received = lidar.pointsReceived;
+    uint64_t suppressed = lidar.pointsSuppressed;
+    ImGui::TextColored(ImVec4(0.0f, 1.0f, 1.0f, 1.0f), "LIDAR");
+    ImGui::Separator();
+    ImGui::Text("Scans: %llu (%llu delta)", static_cast<unsigned long long>(lidar.scans.load()),
+                static_cast<unsigned long long>(lidar.deltaScans.load()));
+    ImGui::Text("Points: %llu", static_cast<unsigned long long>(received));
+    if (suppressed > 0) {
+        ImGui::Text("Suppressed: %llu (%.0f%%)", static_cast<unsigned long long>(suppressed),
+                    100.0 * suppressed / (received + suppressed));
+    }
+    if (lidar.incompleteScans > 0) {
+        ImGui::Text("Incomplete scans: %llu", static_cast<unsigned long long>(lidar.incompleteScans.load()));
+    }
+    // Scan buffers grown this rover's latest scan (0 once the pool is warm)
+    ImGui::Text("Allocations: %u/scan (%llu total)", lidar.scanAllocations.load(),
+                static_cast<unsigned long long>(lidar.allocations.load()));
+    // Scans waiting for the integration thread, all rovers
+    ImGui::Text("Integration queue: %zu/%zu", dataManager->getQueuedScans(), ScanQueue::CAPACITY);
+    if (dataManager->getDroppedScans() > 0) {
+        ImGui::Text("Dropped (queue full): %llu", static_cast<unsigned long long>(dataManager->getDroppedScans()));
+    }
+
+    ImGui::Spacing();
+
+    // Per-stream loss and reordering, from the packet sequence numbers
+    const RoverLinkStats& link = udpReceiver->getLinkStats(selectedRover);
+    ImGui::TextColored(ImVec4(0.0f, 1.0f, 1.0f, 1.0f), "LINK");
+    ImGui::Separator();
+    ImGui::Text("Transport: %s", udpReceiver->isSharedMemoryActive(selectedRover) ? "shared memory" : "UDP");
+    const std::pair<const char*, const SequenceTracker*> streams[] = {
+        { "Pose", &link.pose }, { "LiDAR", &link.lidar }, { "Telem", &link.telemetry },
+        { "State", &link.state } };
+    for (const auto& stream : streams) {
+        if (stream.second->getReceived() == 0) continue;  // stream not in use
+        ImGui::Text("%-5s loss %.1f%%  reorder %.1f%%  dup %llu", stream.first,
+                    100.0 * stream.second->getLossRate(), 100.0 * stream.second->getReorderRate(),
+                    static_cast<unsigned long long>(stream.second->getDuplicates()));
+    }
+    // Kernel drops for a full receive queue; the shared ingest socket
+    // can't attribute them to a rover
+    if (udpReceiver->isMultiplexed() && udpReceiver->getSocketOverflows() > 0) {
+        ImGui::Text("Socket overflows (all rovers): %llu",
+                    static_cast<unsigned long long>(udpReceiver->getSocketOverflows()));
+    } else if (link.socketOverflows > 0) {
+        ImGui::Text("Socket overflows: %llu", static_cast<unsigned long long>(link.socketOverflows.load()));
+    }
+    // Receive loop, all workers: batching and wakeups over the last second
+    const ReceiveLoopRates loop = udpReceiver->getLoopRates();
+    ImGui::Text("Receive: %.1f datagrams/call, %.0f wakeups/s",
+                loop.callsPerSecond > 0.0 ? loop.datagramsPerSecond / loop.callsPerSecond : 0.0,
+                loop.wakeupsPerSecond);
+    if (udpReceiver->getWorkerCount() > 1) {
+        ImGui::Text("Worker: %d of %d", udpReceiver->getWorker(selectedRover) + 1, udpReceiver->getWorkerCount());
+        if (udpReceiver->getMisroutedDatagrams() > 0) {
+            ImGui::Text("Misrouted (all rovers): %llu",
+                        static_cast<unsigned long long>(udpReceiver->getMisroutedDatagrams()));
+        }
+    }
+
     ImGui::Spacing();
     ImGui::Spacing();
     